@@ -0,0 +1,42 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+// Configure time probe, prints per call cost of the clock sources (see Clock.h)
+
+#include <cstdio>
+
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/Time.h"
+
+template<typename F>
+static double cost(F func)
+{
+   const int n            = 1000000;
+   volatile std::int64_t sink = 0;
+   const std::int64_t t0  = evo::Clock::systemNSec();
+   for(int i = 0; i < n; i++)
+   {
+      sink = sink + static_cast<std::int64_t>(func());
+   }
+   return static_cast<double>(evo::Clock::systemNSec() - t0) / n;
+}
+
+int main()
+{
+   const double sys = cost([] { return evo::Clock::raw(); });
+   const double now = cost([] { return evo::Time::now().toNSec(); });
+   std::printf("system clock %.1f ns, Time::now() %.1f ns", sys, now);
+   if(evo::Clock::enableTsc())
+   {
+      const double tsc     = cost([] { return evo::Clock::raw(); });
+      const double tsc_now = cost([] { return evo::Time::now().toNSec(); });
+      std::printf(", TSC raw %.1f ns, TSC Time::now() %.1f ns", tsc, tsc_now);
+   }
+   else
+   {
+      std::printf(", TSC not supported");
+   }
+   return 0;
+}
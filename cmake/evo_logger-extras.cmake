@@ -0,0 +1,22 @@
+## Compile time minimum log level for the EVO_DEBUG/EVO_INFO/... macros
+## (see include/evo_logger/log/LogMacros.h), levels below are removed.
+## Included by packages depending on evo_logger via catkin CFG_EXTRAS.
+if(CMAKE_BUILD_TYPE MATCHES "^(Release|MinSizeRel)$")
+  set(EVO_LOG_MIN_LEVEL_DEFAULT "INFO")
+else()
+  set(EVO_LOG_MIN_LEVEL_DEFAULT "DEBUG")
+endif()
+
+set(EVO_LOG_MIN_LEVEL ${EVO_LOG_MIN_LEVEL_DEFAULT} CACHE STRING
+    "Minimum log level compiled in by evo_logger macros (DEBUG, INFO, WARN, ERROR)")
+set_property(CACHE EVO_LOG_MIN_LEVEL PROPERTY STRINGS DEBUG INFO WARN ERROR)
+
+add_definitions(-DEVO_LOG_MIN_LEVEL=EVO_LOG_LEVEL_${EVO_LOG_MIN_LEVEL})
+
+## Optional zlib for compression of rotated log files (see LogArchiver.h)
+find_package(ZLIB QUIET)
+if(ZLIB_FOUND)
+  add_definitions(-DEVO_LOGGER_HAS_ZLIB)
+  include_directories(${ZLIB_INCLUDE_DIRS})
+  list(APPEND evo_logger_LIBRARIES ${ZLIB_LIBRARIES})
+endif()
@@ -0,0 +1,140 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOTHREADREGISTRY_H_
+#define EVOTHREADREGISTRY_H_
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace evo {
+
+/**
+ * @brief One instance of T per thread, registered so other threads can read all
+ * of them (used by StatsRegistry and Profiler)
+ *
+ * A thread gets its T on first local(), which is written by the thread only. When
+ * the thread ends, Totals::retire(const T&) keeps its values under the registry
+ * mutex before the T is deleted. Totals::attach(T&) is called for every new T.
+ * After the thread locals of a thread were destroyed (e.g. in destructors of
+ * static objects) local() returns nullptr, so values of this phase are lost
+ * instead of being written by several threads at once.
+ *
+ * @author MSC
+ */
+template<typename T, typename Totals>
+class ThreadRegistry
+{
+ public:
+   /**
+    * Getter for instance of calling thread, created on first call
+    *
+    * @return instance, nullptr after thread locals were destroyed or out of memory
+    */
+   static T* local() noexcept
+   {
+      T* obj = ThreadRegistry::current();
+      if(obj || ThreadRegistry::closed())
+      {
+         return obj;
+      }
+      try
+      {
+         thread_local Holder holder;
+         return holder.obj;
+      } catch(std::bad_alloc& e)
+      {
+         return nullptr;
+      }
+   }
+
+   /**
+    * Calls func(totals, threads) with the values of ended threads and the
+    * instances of running threads, no thread starts or ends meanwhile
+    *
+    * @param[in] func called under registry mutex
+    */
+   template<typename F>
+   static void visit(F func)
+   {
+      Registry& reg = ThreadRegistry::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      func(static_cast<const Totals&>(reg.totals),
+           static_cast<const std::vector<T*>&>(reg.threads));
+   }
+
+ private:
+   /**
+    * Instances of all threads
+    */
+   struct Registry
+   {
+      std::mutex mutex;        ///< protects members
+      std::vector<T*> threads; ///< instances of running threads
+      Totals totals;           ///< values of ended threads
+   };
+
+   /**
+    * Registers instance of a thread, retires it when the thread ends
+    */
+   struct Holder
+   {
+      Holder() : obj(nullptr)
+      {
+         std::unique_ptr<T> created(new T);
+         Registry& reg = ThreadRegistry::registry();
+         std::lock_guard<std::mutex> lock(reg.mutex);
+         reg.threads.push_back(created.get());
+         reg.totals.attach(*created);
+         obj                       = created.release();
+         ThreadRegistry::current() = obj;
+      }
+
+      ~Holder()
+      {
+         Registry& reg = ThreadRegistry::registry();
+         std::lock_guard<std::mutex> lock(reg.mutex);
+         reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), obj));
+         reg.totals.retire(*obj);
+         ThreadRegistry::current() = nullptr;
+         ThreadRegistry::closed()  = true;
+         delete obj;
+      }
+
+      T* obj; ///< instance of thread
+   };
+
+   /**
+    * Instance of calling thread, trivially destructible so still valid after the
+    * Holder was destroyed
+    */
+   static T*& current()
+   {
+      thread_local T* obj = nullptr;
+      return obj;
+   }
+
+   /**
+    * True after the Holder of the calling thread was destroyed
+    */
+   static bool& closed()
+   {
+      thread_local bool closed = false;
+      return closed;
+   }
+
+   static Registry& registry()
+   {
+      static Registry* registry = new Registry; // used by thread_local destructors
+      return *registry;
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOTHREADREGISTRY_H_ */
@@ -0,0 +1,688 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOBINARYLOG_H_
+#define EVOBINARYLOG_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "evo_logger/log/FlushPolicy.h"
+#include "evo_logger/log/Format.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/Time.h"
+
+namespace evo {
+
+/**
+ * @brief Binary log file layout, shared by BinaryLog and BinaryReader
+ *
+ * A file starts with MAGIC, followed by records in native byte order:
+ *
+ * - format record: u8 FORMAT, u32 id, u32 length, chars of format string
+ * - log record:    u8 LOG, u32 id, i64 timestamp [ns], u32 level, u8 number of
+ *                  args, every arg as u8 ArgType + payload
+ *
+ * Payload is i64 (INT), u64 (UINT, POINTER), double (DOUBLE) or u32 length +
+ * chars (STRING). A format record is written before the first log record using it.
+ */
+namespace BinaryFormat {
+
+static const char MAGIC[8] = {'E', 'V', 'O', 'B', 'L', 'O', 'G', '1'}; ///< header
+
+static const std::uint8_t FORMAT = 1; ///< record kind format definition
+static const std::uint8_t LOG    = 2; ///< record kind log
+
+/**
+ * Types of encoded printf arguments
+ */
+enum ArgType : std::uint8_t
+{
+   INT     = 1, ///< signed integer, enums
+   UINT    = 2, ///< unsigned integer, bool
+   DOUBLE  = 3, ///< floating point
+   STRING  = 4, ///< C-string or std::string, copied
+   POINTER = 5  ///< any other pointer, address only
+};
+
+} // namespace BinaryFormat
+
+/**
+ * @brief Binary log file with deferred formatting
+ *
+ * append() stores only format string id, raw timestamp, level and the argument
+ * bytes into a buffer, formatting is done offline by evo_log_decoder (see
+ * BinaryReader). The format string is identified by its address, so it has to be
+ * a string literal: a runtime string would be decoded with the format of an
+ * earlier string at the same address and every new address adds a format record.
+ * Logger passes only the format literals of the EVO_* macro call sites (checked
+ * by EVO_FORMAT_CHECK), other logs are appended as "%s" with formatted text. The
+ * buffer is appended to the file when a trigger of the FlushPolicy fires or on
+ * write().
+ *
+ * @author MSC
+ */
+class BinaryLog
+{
+ public:
+   /**
+    * Not null terminated text, encoded as STRING
+    */
+   struct Text
+   {
+      const char* data; ///< first char
+      std::size_t size; ///< number of chars
+   };
+
+   /**
+    * Constructor
+    *
+    * @param[in] file for writing binary logs
+    * @param[in] policy triggers for writing buffer to file
+    */
+   BinaryLog(const std::string& file, const FlushPolicy& policy) :
+       _file(file), _policy(policy), _last_write(Time::now())
+   {
+      _buf.reserve(policy.max_bytes ? policy.max_bytes : 1 << 16);
+      std::ofstream out(_file.c_str(), std::ios::binary | std::ios::app);
+      if(out && out.tellp() == 0)
+      {
+         out.write(BinaryFormat::MAGIC, sizeof(BinaryFormat::MAGIC));
+      }
+   }
+
+   /**
+    * Destructor writes buffer to file
+    */
+   ~BinaryLog() { this->write(); }
+
+   /**
+    * Encodes one log record
+    *
+    * @param[in] level log level
+    * @param[in] fmt   printf-style format string, has to be a string literal
+    * @param[in] args  printf args
+    */
+   template<typename... Args>
+   void append(Log::Log level, const char* fmt, Args... args)
+   {
+      const std::int64_t stamp = Clock::nowNSec();
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      const FormatInfo& info = this->formatInfo(fmt);
+      this->put(BinaryFormat::LOG);
+      this->put(info.id);
+      this->put(stamp);
+      this->put(static_cast<std::uint32_t>(level));
+      this->put(static_cast<std::uint8_t>(sizeof...(Args)));
+      this->putArgs(info.pointers, args...);
+      _records++;
+
+      const double elapsed = (Time::fromNSec(stamp) - _last_write).toSec();
+      if(_policy.due(_records, _buf.size(), elapsed, level))
+      {
+         this->writeBuffer();
+      }
+   }
+
+   /**
+    * Writes buffer to file (appends file)
+    */
+   void write()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      this->writeBuffer();
+   }
+
+   /**
+    * Setter for triggers which write buffer to file
+    *
+    * @param[in] policy flush triggers
+    */
+   void setFlushPolicy(const FlushPolicy& policy)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _policy = policy;
+   }
+
+   /**
+    * Getter for file name
+    *
+    * @return file name
+    */
+   const std::string& getFile() const { return _file; }
+
+ private:
+   /**
+    * Id of format string and its %p arguments
+    */
+   struct FormatInfo
+   {
+      std::uint32_t id;       ///< id of format string
+      std::uint64_t pointers; ///< bit i set if argument i is converted by %p
+   };
+
+   /**
+    * Looks up format string, writes format record on first usage
+    *
+    * @param[in] fmt format string
+    * @return id and %p arguments of format string
+    */
+   const FormatInfo& formatInfo(const char* fmt)
+   {
+      auto it = _ids.find(fmt);
+      if(it != _ids.end())
+      {
+         return it->second;
+      }
+      const std::uint32_t id  = static_cast<std::uint32_t>(_ids.size());
+      const std::uint32_t len = static_cast<std::uint32_t>(std::strlen(fmt));
+      this->put(BinaryFormat::FORMAT);
+      this->put(id);
+      this->put(len);
+      this->putBytes(fmt, len);
+      return _ids.emplace(fmt, FormatInfo{id, BinaryLog::pointerArgs(fmt)})
+          .first->second;
+   }
+
+   /**
+    * Finds arguments converted by %p, so C-strings are encoded as address there
+    * ('*' of width or precision counts as argument, like in FormatCheck)
+    *
+    * @param[in] f format string
+    * @return bit i set if argument i is converted by %p (first 64 arguments)
+    */
+   static std::uint64_t pointerArgs(const char* f)
+   {
+      std::uint64_t pointers = 0;
+      unsigned int arg       = 0;
+      while((f = std::strchr(f, '%')))
+      {
+         if(*++f == '%')
+         {
+            f++;
+            continue;
+         }
+         while(FormatTraits::isFlag(*f))
+         {
+            f++;
+         }
+         if(*f == '*')
+         {
+            arg++;
+            f++;
+         }
+         f = FormatTraits::skipDigits(f);
+         if(*f == '.')
+         {
+            arg += f[1] == '*';
+            f = FormatTraits::skipDigits(f + (f[1] == '*' ? 2 : 1));
+         }
+         while(FormatTraits::isLength(*f))
+         {
+            f++;
+         }
+         if(*f == 'p' && arg < 64)
+         {
+            pointers |= 1ull << arg;
+         }
+         if(*f)
+         {
+            f++;
+         }
+         arg++;
+      }
+      return pointers;
+   }
+
+   void putBytes(const void* data, const std::size_t size)
+   {
+      const std::size_t pos = _buf.size();
+      _buf.resize(pos + size);
+      std::memcpy(&_buf[pos], data, size);
+   }
+
+   template<typename T>
+   void put(const T value)
+   {
+      this->putBytes(&value, sizeof(T));
+   }
+
+   void putArgs(const std::uint64_t) {}
+
+   /**
+    * Encodes arguments
+    *
+    * @param[in] pointers bit 0 set if first argument is converted by %p
+    * @param[in] arg      first argument
+    * @param[in] args     other arguments
+    */
+   template<typename T, typename... Args>
+   void putArgs(const std::uint64_t pointers, T arg, Args... args)
+   {
+      this->putArg(arg, (pointers & 1) != 0);
+      this->putArgs(pointers >> 1, args...);
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+   putArg(const T arg, bool)
+   {
+      this->put(BinaryFormat::INT);
+      this->put(static_cast<std::int64_t>(arg));
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_integral<T>::value &&
+                           !std::is_signed<T>::value>::type
+   putArg(const T arg, bool)
+   {
+      this->put(BinaryFormat::UINT);
+      this->put(static_cast<std::uint64_t>(arg));
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_enum<T>::value>::type putArg(const T arg, bool)
+   {
+      this->put(BinaryFormat::INT);
+      this->put(static_cast<std::int64_t>(arg));
+   }
+
+   template<typename T>
+   typename std::enable_if<std::is_floating_point<T>::value>::type
+   putArg(const T arg, bool)
+   {
+      this->put(BinaryFormat::DOUBLE);
+      this->put(static_cast<double>(arg));
+   }
+
+   template<typename T>
+   void putArg(const T* arg, bool)
+   {
+      this->put(BinaryFormat::POINTER);
+      this->put(static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(arg)));
+   }
+
+   void putArg(std::nullptr_t, bool)
+   {
+      this->putArg(static_cast<const void*>(nullptr), true);
+   }
+
+   // C-string, address for %p
+   void putArg(const char* arg, const bool pointer)
+   {
+      if(pointer)
+      {
+         this->putArg(static_cast<const void*>(arg), true);
+         return;
+      }
+      if(!arg)
+      {
+         arg = "(null)";
+      }
+      this->putArg(Text{arg, std::strlen(arg)}, false);
+   }
+
+   void putArg(char* arg, const bool pointer)
+   {
+      this->putArg(static_cast<const char*>(arg), pointer);
+   }
+
+   void putArg(const std::string& arg, bool)
+   {
+      this->putArg(Text{arg.data(), arg.size()}, false);
+   }
+
+   void putArg(const Text& arg, bool)
+   {
+      this->put(BinaryFormat::STRING);
+      this->put(static_cast<std::uint32_t>(arg.size));
+      this->putBytes(arg.data, arg.size);
+   }
+
+   /**
+    * Appends buffer to file and clears it, caller has to hold _mutex
+    */
+   void writeBuffer()
+   {
+      _records    = 0;
+      _last_write = Time::now();
+      if(_buf.empty())
+      {
+         return;
+      }
+      std::ofstream out(_file.c_str(), std::ios::binary | std::ios::app);
+      if(out)
+      {
+         out.write(_buf.data(), static_cast<std::streamsize>(_buf.size()));
+      }
+      _buf.clear();
+   }
+
+   std::string _file;                                ///< binary log file
+   FlushPolicy _policy;                              ///< triggers for writing
+   std::vector<char> _buf;                           ///< encoded records
+   std::size_t _records = 0;                         ///< records in _buf
+   Time _last_write;                                 ///< time of last write
+   std::unordered_map<const char*, FormatInfo> _ids; ///< format strings by address
+   std::mutex _mutex;                                ///< protects all members
+};
+
+/**
+ * @brief Reads and formats files written by BinaryLog
+ *
+ * Used offline, e.g. by evo_log_decoder.
+ *
+ * @author MSC
+ */
+class BinaryReader
+{
+ public:
+   /**
+    * Decoded printf argument
+    */
+   struct Arg
+   {
+      BinaryFormat::ArgType type; ///< type of argument
+      std::int64_t i;             ///< value of INT
+      std::uint64_t u;            ///< value of UINT and POINTER
+      double d;                   ///< value of DOUBLE
+      std::string s;              ///< value of STRING
+   };
+
+   /**
+    * Reads whole file and calls func for every log record in file order
+    *
+    * @param[in] file binary log file
+    * @param[in] func called with decoded log
+    * @return false if file could not be read or is corrupted
+    */
+   static bool read(const std::string& file, const std::function<void(const LogObj&)>& func)
+   {
+      std::ifstream in(file.c_str(), std::ios::binary);
+      if(!in)
+      {
+         return false;
+      }
+      std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+
+      if(data.size() < sizeof(BinaryFormat::MAGIC) ||
+         std::memcmp(data.data(), BinaryFormat::MAGIC, sizeof(BinaryFormat::MAGIC)))
+      {
+         return false;
+      }
+
+      std::unordered_map<std::uint32_t, std::string> formats;
+      std::vector<Arg> args;
+      std::size_t pos = sizeof(BinaryFormat::MAGIC);
+      while(pos < data.size())
+      {
+         std::uint8_t kind = 0;
+         std::uint32_t id  = 0;
+         if(!get(data, pos, kind) || !get(data, pos, id))
+         {
+            return false;
+         }
+         if(kind == BinaryFormat::FORMAT)
+         {
+            std::string fmt;
+            if(!getString(data, pos, fmt))
+            {
+               return false;
+            }
+            formats[id] = fmt;
+            continue;
+         }
+         if(kind != BinaryFormat::LOG)
+         {
+            return false;
+         }
+
+         std::int64_t stamp  = 0;
+         std::uint32_t level = 0;
+         std::uint8_t nargs  = 0;
+         if(!get(data, pos, stamp) || !get(data, pos, level) || !get(data, pos, nargs))
+         {
+            return false;
+         }
+         args.resize(nargs);
+         for(auto& arg : args)
+         {
+            if(!getArg(data, pos, arg))
+            {
+               return false;
+            }
+         }
+         auto fmt = formats.find(id);
+         if(fmt == formats.end())
+         {
+            return false;
+         }
+         LogObj obj = {Time(static_cast<double>(stamp) * 1e-9),
+                       static_cast<Log::Log>(level), format(fmt->second, args)};
+         func(obj);
+      }
+      return true;
+   }
+
+   /**
+    * Formats printf-style format string with decoded args
+    *
+    * Length modifiers of the format string are replaced by the ones matching the
+    * encoded type. If the conversion does not fit the encoded type, the arg is
+    * formatted with the default conversion of its type.
+    *
+    * @param[in] fmt  printf-style format string
+    * @param[in] args decoded args
+    * @return formatted string
+    */
+   static std::string format(const std::string& fmt, const std::vector<Arg>& args)
+   {
+      std::string out;
+      std::size_t next = 0;
+      std::size_t i    = 0;
+      while(i < fmt.size())
+      {
+         if(fmt[i] != '%')
+         {
+            out += fmt[i++];
+            continue;
+         }
+         if(i + 1 < fmt.size() && fmt[i + 1] == '%')
+         {
+            out += '%';
+            i += 2;
+            continue;
+         }
+
+         // %[flags][width][.precision][length]conversion
+         std::string spec = "%";
+         i++;
+         while(i < fmt.size() && std::strchr("-+ #0", fmt[i]))
+         {
+            spec += fmt[i++];
+         }
+         i = starOrDigits(fmt, i, spec, args, next);
+         if(i < fmt.size() && fmt[i] == '.')
+         {
+            spec += fmt[i++];
+            i = starOrDigits(fmt, i, spec, args, next);
+         }
+         while(i < fmt.size() && std::strchr("hlLqjzt", fmt[i]))
+         {
+            i++; // replaced below
+         }
+         if(i >= fmt.size())
+         {
+            break;
+         }
+         const char conv = fmt[i++];
+         if(next >= args.size())
+         {
+            out += "(missing)";
+            continue;
+         }
+         if(conv != 'n')
+         {
+            out += formatArg(spec, conv, args[next]);
+         }
+         next++;
+      }
+      return out;
+   }
+
+ private:
+   template<typename T>
+   static bool get(const std::vector<char>& data, std::size_t& pos, T& value)
+   {
+      if(pos + sizeof(T) > data.size())
+      {
+         return false;
+      }
+      std::memcpy(&value, &data[pos], sizeof(T));
+      pos += sizeof(T);
+      return true;
+   }
+
+   static bool getString(const std::vector<char>& data, std::size_t& pos,
+                         std::string& str)
+   {
+      std::uint32_t len = 0;
+      if(!get(data, pos, len) || pos + len > data.size())
+      {
+         return false;
+      }
+      str.assign(&data[pos], len);
+      pos += len;
+      return true;
+   }
+
+   static bool getArg(const std::vector<char>& data, std::size_t& pos, Arg& arg)
+   {
+      std::uint8_t type = 0;
+      if(!get(data, pos, type))
+      {
+         return false;
+      }
+      arg.type = static_cast<BinaryFormat::ArgType>(type);
+      switch(arg.type)
+      {
+         case BinaryFormat::INT: return get(data, pos, arg.i);
+         case BinaryFormat::UINT:
+         case BinaryFormat::POINTER: return get(data, pos, arg.u);
+         case BinaryFormat::DOUBLE: return get(data, pos, arg.d);
+         case BinaryFormat::STRING: return getString(data, pos, arg.s);
+         default: return false;
+      }
+   }
+
+   /**
+    * Copies width or precision to spec, '*' is replaced by the next arg
+    */
+   static std::size_t starOrDigits(const std::string& fmt, std::size_t i,
+                                   std::string& spec, const std::vector<Arg>& args,
+                                   std::size_t& next)
+   {
+      if(i < fmt.size() && fmt[i] == '*')
+      {
+         if(next < args.size())
+         {
+            const Arg& arg = args[next++];
+            spec += std::to_string(arg.type == BinaryFormat::INT
+                                       ? arg.i
+                                       : static_cast<std::int64_t>(arg.u));
+         }
+         return i + 1;
+      }
+      while(i < fmt.size() && fmt[i] >= '0' && fmt[i] <= '9')
+      {
+         spec += fmt[i++];
+      }
+      return i;
+   }
+
+   static std::string formatArg(std::string spec, const char conv, const Arg& arg)
+   {
+      const bool is_int = arg.type == BinaryFormat::INT || arg.type == BinaryFormat::UINT;
+      const long long i = arg.type == BinaryFormat::INT ? static_cast<long long>(arg.i)
+                                                        : static_cast<long long>(arg.u);
+      if(is_int && std::strchr("di", conv))
+      {
+         return sprintf(spec + "lld", i);
+      }
+      if(is_int && std::strchr("uxXo", conv))
+      {
+         return sprintf(spec + "ll" + conv, static_cast<unsigned long long>(i));
+      }
+      if(is_int && conv == 'c')
+      {
+         return sprintf(spec + conv, static_cast<int>(i));
+      }
+      if(arg.type == BinaryFormat::DOUBLE && std::strchr("fFeEgGaA", conv))
+      {
+         return sprintf(spec + conv, arg.d);
+      }
+      if(arg.type == BinaryFormat::STRING && conv == 's')
+      {
+         return sprintf(spec + conv, arg.s.c_str());
+      }
+      if(arg.type == BinaryFormat::POINTER && conv == 'p')
+      {
+         return sprintf(spec + conv,
+                        reinterpret_cast<void*>(static_cast<std::uintptr_t>(arg.u)));
+      }
+
+      // conversion does not fit encoded type -> default conversion of type
+      switch(arg.type)
+      {
+         case BinaryFormat::INT: return formatArg(spec, 'd', arg);
+         case BinaryFormat::UINT: return formatArg(spec, 'u', arg);
+         case BinaryFormat::DOUBLE: return formatArg(spec, 'g', arg);
+         case BinaryFormat::STRING: return formatArg(spec, 's', arg);
+         default: return formatArg(spec, 'p', arg);
+      }
+   }
+
+   /**
+    * snprintf for a single conversion
+    *
+    * @param[in] spec  printf-style conversion specification
+    * @param[in] value value to format
+    * @return formatted string
+    */
+   template<typename T>
+   static std::string sprintf(const std::string& spec, const T value)
+   {
+      char buf[256];
+      const int n = std::snprintf(buf, sizeof(buf), spec.c_str(), value);
+      if(n < 0)
+      {
+         return std::string();
+      }
+      if(static_cast<std::size_t>(n) < sizeof(buf))
+      {
+         return std::string(buf, static_cast<std::size_t>(n));
+      }
+      std::string str(static_cast<std::size_t>(n) + 1, '\0');
+      std::snprintf(&str[0], str.size(), spec.c_str(), value);
+      str.resize(static_cast<std::size_t>(n));
+      return str;
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOBINARYLOG_H_ */
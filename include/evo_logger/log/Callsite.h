@@ -0,0 +1,304 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOCALLSITE_H_
+#define EVOCALLSITE_H_
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "evo_logger/log/LogType.h"
+
+namespace evo {
+
+namespace CallsiteState {
+/**
+ * Runtime state of a call site, see Callsite::enable()
+ */
+enum CallsiteState : int
+{
+   UNREGISTERED = 0, ///< not executed yet
+   DEFAULT      = 1, ///< logged if its level is enabled
+   ON           = 2, ///< always logged, printed and stored
+   OFF          = 3  ///< never logged
+};
+} // namespace CallsiteState
+
+/**
+ * @brief Static descriptor of one log call site (file, line, function, level,
+ * format), created by the EVO_* macros of LogMacros.h
+ *
+ * The macros keep one instance in static storage per call site (constant
+ * initialized, no guard), it registers itself on first execution. Records carry a
+ * pointer to it, the location "file:line" is printed in front of the message if
+ * enabled with setLocation(). Single call sites or whole files can be switched on
+ * or off at runtime, also before they were executed (like Linux dynamic debug):
+ *
+ * @code
+ * evo::Callsite::enable("driver.cpp", 42); // DEBUG line logged without DEBUG level
+ * evo::Callsite::disable("noisy.cpp");     // every call site of file
+ * evo::Callsite::reset();                  // all call sites follow levels again
+ * @endcode
+ *
+ * @note descriptors of unloaded shared libraries must not be logged anymore
+ *
+ * @author MSC
+ */
+class Callsite
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] level    log level of call site
+    * @param[in] file     source file (__FILE__)
+    * @param[in] line     source line (__LINE__)
+    * @param[in] function function name (__func__)
+    * @param[in] format   format string or stream expression
+    */
+   constexpr Callsite(Log::Log level, const char* file, const int line,
+                      const char* function, const char* format) :
+       _level(level),
+       _file(file), _line(line), _function(function), _format(format), _where(),
+       _state(CallsiteState::UNREGISTERED), _next(nullptr)
+   {
+   }
+
+   Callsite(const Callsite&) = delete;
+   Callsite& operator=(const Callsite&) = delete;
+
+   Log::Log level() const { return _level; }
+
+   const char* file() const { return _file; }
+
+   int line() const { return _line; }
+
+   const char* function() const { return _function; }
+
+   const char* format() const { return _format; }
+
+   /**
+    * Getter for location, valid after first execution
+    *
+    * @return "<file name>:<line>"
+    */
+   const char* where() const { return _where; }
+
+   /**
+    * Getter for runtime state, registers call site on first call
+    *
+    * @return state
+    */
+   CallsiteState::CallsiteState state()
+   {
+      const int state = _state.load(std::memory_order_acquire);
+      return state ? static_cast<CallsiteState::CallsiteState>(state)
+                   : this->registerSite();
+   }
+
+   /**
+    * Proves if call site was switched on with enable()
+    *
+    * @param[in] site call site, may be nullptr
+    * @return true if site is forced on
+    */
+   static bool forced(const Callsite* site)
+   {
+      return site &&
+             site->_state.load(std::memory_order_relaxed) == CallsiteState::ON;
+   }
+
+   /**
+    * Switches call sites on, their logs are printed and stored regardless of the
+    * log levels
+    *
+    * @param[in] file file name or path suffix, "" for all files
+    * @param[in] line source line, 0 for all lines of file
+    */
+   static void enable(const std::string& file, const int line = 0)
+   {
+      Callsite::addRule(file, line, CallsiteState::ON);
+   }
+
+   /**
+    * Switches call sites off, their logs are dropped
+    *
+    * @param[in] file file name or path suffix, "" for all files
+    * @param[in] line source line, 0 for all lines of file
+    */
+   static void disable(const std::string& file, const int line = 0)
+   {
+      Callsite::addRule(file, line, CallsiteState::OFF);
+   }
+
+   /**
+    * Lets call sites follow the log levels again
+    *
+    * @param[in] file file name or path suffix, "" for all files
+    * @param[in] line source line, 0 for all lines of file
+    */
+   static void reset(const std::string& file = "", const int line = 0)
+   {
+      Callsite::addRule(file, line, CallsiteState::DEFAULT);
+   }
+
+   /**
+    * Calls func for every registered call site (executed at least once)
+    *
+    * @param[in] func called with call site
+    */
+   static void forEach(const std::function<void(const Callsite&)>& func)
+   {
+      std::lock_guard<std::mutex> lock(Callsite::registry().mutex);
+      for(const Callsite* site = Callsite::registry().head; site; site = site->_next)
+      {
+         func(*site);
+      }
+   }
+
+   /**
+    * Enables or disables printing of location "file:line" in front of messages
+    *
+    * @param[in] enable true to print location
+    */
+   static void setLocation(const bool enable)
+   {
+      Callsite::registry().location.store(enable, std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for location of record if printing of location is enabled
+    *
+    * @param[in] site call site of record, may be nullptr
+    * @return location or nullptr
+    */
+   static const char* location(const Callsite* site)
+   {
+      return site && Callsite::registry().location.load(std::memory_order_relaxed)
+                 ? site->_where
+                 : nullptr;
+   }
+
+ private:
+   /**
+    * Rule of enable(), disable() or reset()
+    */
+   struct Rule
+   {
+      std::string file; ///< file name or path suffix, empty for all
+      int line;         ///< line, 0 for all
+      int state;        ///< state of matching call sites
+   };
+
+   /**
+    * Registered call sites and rules
+    */
+   struct Registry
+   {
+      std::mutex mutex;                 ///< protects members below
+      Callsite* head = nullptr;         ///< registered call sites
+      std::vector<Rule> rules;          ///< rules, applied in order
+      std::atomic<bool> location{false}; ///< print location
+   };
+
+   static Registry& registry()
+   {
+      static Registry registry;
+      return registry;
+   }
+
+   /**
+    * Registers call site and applies rules
+    *
+    * @return state of call site
+    */
+   CallsiteState::CallsiteState registerSite()
+   {
+      Registry& reg = Callsite::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      const int state = _state.load(std::memory_order_relaxed);
+      if(state) // registered by other thread
+      {
+         return static_cast<CallsiteState::CallsiteState>(state);
+      }
+      const char* name = std::strrchr(_file, '/');
+      std::snprintf(_where, sizeof(_where), "%s:%d", name ? name + 1 : _file, _line);
+      int result = CallsiteState::DEFAULT;
+      for(const Rule& rule : reg.rules)
+      {
+         if(this->matches(rule))
+         {
+            result = rule.state;
+         }
+      }
+      _next    = reg.head;
+      reg.head = this;
+      _state.store(result, std::memory_order_release);
+      return static_cast<CallsiteState::CallsiteState>(result);
+   }
+
+   /**
+    * Stores rule for later registered call sites and applies it to registered ones
+    */
+   static void addRule(const std::string& file, const int line, const int state)
+   {
+      Registry& reg = Callsite::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      const Rule rule = {file, line, state};
+      if(file.empty() && !line && state == CallsiteState::DEFAULT)
+      {
+         reg.rules.clear(); // reset of everything
+      }
+      else
+      {
+         reg.rules.push_back(rule);
+      }
+      for(Callsite* site = reg.head; site; site = site->_next)
+      {
+         if(site->matches(rule))
+         {
+            site->_state.store(state, std::memory_order_relaxed);
+         }
+      }
+   }
+
+   /**
+    * Proves if rule matches call site, file matches if it is a path suffix
+    */
+   bool matches(const Rule& rule) const
+   {
+      if(rule.line && rule.line != _line)
+      {
+         return false;
+      }
+      const std::size_t len  = std::strlen(_file);
+      const std::size_t size = rule.file.size();
+      if(size > len || rule.file.compare(_file + len - size) != 0)
+      {
+         return false;
+      }
+      // whole file or directory name only
+      return size == len || !size || rule.file[0] == '/' ||
+             _file[len - size - 1] == '/';
+   }
+
+   const Log::Log _level;      ///< log level
+   const char* _file;          ///< source file
+   const int _line;            ///< source line
+   const char* _function;      ///< function name
+   const char* _format;        ///< format string or stream expression
+   char _where[LogObj::WHERE_LENGTH]; ///< "<file name>:<line>", set on registration
+   std::atomic<int> _state;    ///< CallsiteState
+   Callsite* _next;            ///< next registered call site
+};
+
+} // namespace evo
+
+#endif /* EVOCALLSITE_H_ */
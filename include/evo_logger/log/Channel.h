@@ -0,0 +1,231 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOCHANNEL_H_
+#define EVOCHANNEL_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "evo_logger/log/LogType.h"
+
+namespace evo {
+
+/**
+ * @brief Named sub-logger in a hierarchy, e.g. "driver.lidar" below "driver"
+ *
+ * Every channel has a level mask, inherited from its parent unless overridden with
+ * setLevel(). The mask filters logs of the channel in addition to the terminal,
+ * file and sink masks of the Logger. Changes are pushed down to all inheriting
+ * children when they are made, so the check of a handle is a single atomic load
+ * without lookup. Channels live until the end of the program, handles obtained
+ * once with get() (or evo::log::channel()) stay valid.
+ *
+ * The name is printed in front of the message: "[driver.lidar] message".
+ *
+ * @code
+ * evo::Channel& lidar = evo::log::channel("driver.lidar");
+ * evo::Channel::root().setLevel(evo::Log::WARN | evo::Log::ERROR); // all channels
+ * lidar.setLevel(evo::Log::ALL);                                  // but lidar
+ * EVO_CH_DEBUG(lidar, "scan %d", n);
+ * @endcode
+ *
+ * @author MSC
+ */
+class Channel
+{
+ public:
+   Channel(const Channel&) = delete;
+   Channel& operator=(const Channel&) = delete;
+
+   /**
+    * Getter for channel by name, creates it and missing parents
+    *
+    * @param[in] name dot separated path, e.g. "driver.lidar", "" for root
+    * @return channel, valid until the end of the program
+    */
+   static Channel& get(const std::string& name)
+   {
+      Registry& reg = Channel::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      return Channel::find(reg, name);
+   }
+
+   /**
+    * Getter for root channel, parent of all channels
+    *
+    * @return root channel
+    */
+   static Channel& root() { return Channel::get(""); }
+
+   /**
+    * Calls func for every channel, parents before children
+    *
+    * @param[in] func called with channel
+    */
+   static void forEach(const std::function<void(const Channel&)>& func)
+   {
+      Registry& reg = Channel::registry();
+      std::lock_guard<std::mutex> lock(reg.mutex);
+      for(const auto& entry : reg.channels) // sorted by name
+      {
+         func(*entry.second);
+      }
+   }
+
+   /**
+    * Getter for full name
+    *
+    * @return dot separated path, "" for root
+    */
+   const std::string& name() const { return _name; }
+
+   /**
+    * Getter for text printed in front of messages
+    *
+    * @return "[name] ", empty for root
+    */
+   const std::string& prefix() const { return _prefix; }
+
+   /**
+    * Getter for parent channel
+    *
+    * @return parent, nullptr for root
+    */
+   Channel* parent() const { return _parent; }
+
+   /**
+    * Proves if channel passes logs of given level
+    *
+    * @param[in] level log level
+    * @return true if level is in mask
+    */
+   bool isEnabled(Log::Log level) const
+   {
+      return static_cast<LogType>(level) & _level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for effective level mask (own or inherited)
+    *
+    * @return level mask
+    */
+   LogType getLevel() const { return _level.load(std::memory_order_relaxed); }
+
+   /**
+    * Proves if level mask is set for this channel instead of inherited
+    *
+    * @return true if overridden with setLevel()
+    */
+   bool hasOwnLevel() const
+   {
+      std::lock_guard<std::mutex> lock(Channel::registry().mutex);
+      return _own;
+   }
+
+   /**
+    * Setter for level mask of this channel and all children inheriting it
+    *
+    * @param[in] level as Log-enum (e.G. Log::INFO), more levels can be appendend
+    * with |-operator
+    */
+   void setLevel(const LogType level)
+   {
+      std::lock_guard<std::mutex> lock(Channel::registry().mutex);
+      _own = true;
+      this->propagate(level);
+   }
+
+   /**
+    * Lets channel inherit the level mask of its parent again (root: Log::ALL)
+    */
+   void resetLevel()
+   {
+      std::lock_guard<std::mutex> lock(Channel::registry().mutex);
+      _own = false;
+      this->propagate(_parent ? _parent->getLevel()
+                              : static_cast<LogType>(Log::ALL));
+   }
+
+ private:
+   /**
+    * All channels
+    */
+   struct Registry
+   {
+      std::mutex mutex; ///< protects tree and _own of channels
+      std::map<std::string, std::unique_ptr<Channel>> channels; ///< by name
+   };
+
+   Channel(const std::string& name, Channel* parent) :
+       _name(name), _prefix(name.empty() ? "" : "[" + name + "] "), _parent(parent),
+       _level(parent ? parent->getLevel() : static_cast<LogType>(Log::ALL))
+   {
+   }
+
+   static Registry& registry()
+   {
+      static Registry registry;
+      return registry;
+   }
+
+   /**
+    * Looks up or creates channel and missing parents, caller holds mutex
+    */
+   static Channel& find(Registry& reg, const std::string& name)
+   {
+      auto it = reg.channels.find(name);
+      if(it != reg.channels.end())
+      {
+         return *it->second;
+      }
+      Channel* parent = nullptr;
+      if(!name.empty())
+      {
+         const std::size_t dot = name.rfind('.');
+         const std::size_t len = dot == std::string::npos ? 0 : dot;
+         parent                = &Channel::find(reg, name.substr(0, len));
+      }
+      Channel* channel = new Channel(name, parent);
+      reg.channels[name].reset(channel);
+      if(parent)
+      {
+         parent->_children.push_back(channel);
+      }
+      return *channel;
+   }
+
+   /**
+    * Sets effective level mask of this channel and inheriting children, caller
+    * holds mutex
+    */
+   void propagate(const LogType level)
+   {
+      _level.store(level, std::memory_order_relaxed);
+      for(Channel* child : _children)
+      {
+         if(!child->_own)
+         {
+            child->propagate(level);
+         }
+      }
+   }
+
+   const std::string _name;          ///< full name
+   const std::string _prefix;        ///< "[name] "
+   Channel* const _parent;           ///< parent, nullptr for root
+   std::vector<Channel*> _children;  ///< direct children
+   std::atomic<LogType> _level;      ///< effective level mask
+   bool _own = false;                ///< level mask set, not inherited
+};
+
+} // namespace evo
+
+#endif /* EVOCHANNEL_H_ */
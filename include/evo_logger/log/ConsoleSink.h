@@ -0,0 +1,346 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOCONSOLESINK_H_
+#define EVOCONSOLESINK_H_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/log/OstreamColor.h"
+
+namespace evo {
+
+/**
+ * @brief Batched terminal output, producers never wait for the terminal
+ *
+ * Logs are formatted with precomputed color escape sequences into a buffer, a
+ * background thread writes the whole buffer with one write() call while the next
+ * batch is collected. If the terminal falls behind and the buffer is full, logs
+ * are dropped (or the producer waits, see setBlocking()) and a summary line with
+ * the number of dropped logs is printed as soon as there is space again. Colors
+ * are disabled if the output is not a terminal.
+ *
+ * @author MSC
+ */
+class ConsoleSink
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] fd       file descriptor for output
+    * @param[in] capacity bytes buffered at most
+    */
+   explicit ConsoleSink(const int fd = STDOUT_FILENO,
+                        const std::size_t capacity = 1 << 20) :
+       _fd(fd),
+       _capacity(capacity), _colors(::isatty(fd) == 1)
+   {
+   }
+
+   ConsoleSink(const ConsoleSink&) = delete;
+   ConsoleSink& operator=(const ConsoleSink&) = delete;
+
+   /**
+    * Destructor writes buffered logs and stops thread
+    */
+   ~ConsoleSink()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _cv.notify_all();
+      if(_thread.joinable())
+      {
+         _thread.join();
+      }
+   }
+
+   /**
+    * Setter for colors of log level
+    *
+    * @param[in] level log level
+    * @param[in] fg    foreground color
+    * @param[in] bg    background color
+    */
+   void setColors(Log::Log level, const OSColor& fg, const OSColor& bg)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _prefix[ConsoleSink::index(level)] = fg.str() + bg.str();
+   }
+
+   /**
+    * Setter for colors restored after each log
+    *
+    * @param[in] fg foreground color
+    * @param[in] bg background color
+    */
+   void setDefaultColors(const OSColor& fg, const OSColor& bg)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _suffix = bg.str() + fg.str();
+   }
+
+   /**
+    * Enables or disables colors, default is enabled if output is a terminal
+    *
+    * @param[in] enable true for colors
+    */
+   void setColorsEnabled(const bool enable)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _colors = enable;
+   }
+
+   /**
+    * Setter for behaviour if buffer is full
+    *
+    * @param[in] block true: producers wait for the terminal, false: logs are
+    * dropped (default)
+    */
+   void setBlocking(const bool block)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _block = block;
+   }
+
+   /**
+    * Formats log into buffer, returns without waiting for the terminal
+    *
+    * @param[in] level log level
+    * @param[in] ns    timestamp [ns] since epoch
+    * @param[in] text  pointer to message
+    * @param[in] len   length of message
+    * @param[in] where location "file:line" printed before message, may be nullptr
+    */
+   void write(Log::Log level, const std::int64_t ns, const char* text,
+              std::size_t len, const char* where = nullptr)
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      const std::string& prefix =
+          _colors ? _prefix[ConsoleSink::index(level)] : _empty;
+      const std::string& suffix = _colors ? _suffix : _empty;
+      const std::size_t overhead =
+          LogObj::maxLength(0) + prefix.size() + suffix.size() + SUMMARY_LENGTH + 1;
+      if(overhead + len > _capacity)
+      {
+         len = _capacity > overhead ? _capacity - overhead : 0; // cut message
+      }
+      const std::size_t need = overhead + len;
+
+      if(_used + need > _capacity)
+      {
+         if(!_block)
+         {
+            _pending_drops++;
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            lock.unlock();
+            _cv.notify_one();
+            return;
+         }
+         const auto start = std::chrono::steady_clock::now();
+         _space.wait(lock, [&] { return _used + need <= _capacity; });
+         const auto waited = std::chrono::steady_clock::now() - start;
+         _stalls.fetch_add(1, std::memory_order_relaxed);
+         _stall_ns.fetch_add(static_cast<std::uint64_t>(
+                                 std::chrono::nanoseconds(waited).count()),
+                             std::memory_order_relaxed);
+      }
+      if(!_front)
+      {
+         _front.reset(new char[_capacity]);
+         _back.reset(new char[_capacity]);
+         _thread = std::thread(&ConsoleSink::run, this);
+      }
+
+      this->summarize();
+      char* dst = _front.get() + _used;
+      std::memcpy(dst, prefix.data(), prefix.size());
+      dst += prefix.size();
+      dst += LogObj::parse(dst, ns, level, text, len, where);
+      std::memcpy(dst, suffix.data(), suffix.size());
+      dst += suffix.size();
+      *dst++ = '\n';
+      _used  = static_cast<std::size_t>(dst - _front.get());
+      lock.unlock();
+      _cv.notify_one();
+   }
+
+   /**
+    * Waits until all buffered logs are written
+    */
+   void flush()
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _space.wait(lock, [this] { return !_used && !_writing; });
+   }
+
+   /**
+    * Getter for number of logs dropped because the terminal was too slow
+    *
+    * @return dropped logs
+    */
+   std::uint64_t getDroppedCount() const
+   {
+      return _dropped.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for number of logs which waited for the terminal (blocking mode)
+    *
+    * @return stalled logs
+    */
+   std::uint64_t getStallCount() const
+   {
+      return _stalls.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for time logs waited for the terminal (blocking mode)
+    *
+    * @return sum of waits [ns]
+    */
+   std::uint64_t getStallNs() const
+   {
+      return _stall_ns.load(std::memory_order_relaxed);
+   }
+
+ private:
+   static const std::size_t SUMMARY_LENGTH = 64; ///< max length of drop summary
+
+   /**
+    * Thread function, writes batches until destructor is called and buffer is
+    * empty
+    */
+   void run()
+   {
+      std::unique_lock<std::mutex> lock(_mutex);
+      for(;;)
+      {
+         _cv.wait(lock, [this] { return _stop || _used || _pending_drops; });
+         this->summarize();
+         if(!_used)
+         {
+            return;
+         }
+         std::swap(_front, _back);
+         const std::size_t size = _used;
+         _used                  = 0;
+         _writing               = true;
+         lock.unlock();
+         _space.notify_all();
+
+         this->writeAll(_back.get(), size);
+
+         lock.lock();
+         _writing = false;
+         _space.notify_all();
+      }
+   }
+
+   /**
+    * Appends summary of dropped logs to buffer, caller has to hold _mutex
+    */
+   void summarize()
+   {
+      if(!_pending_drops || _used + SUMMARY_LENGTH > _capacity)
+      {
+         return;
+      }
+      const unsigned long long drops = _pending_drops;
+      const int n = std::snprintf(_front.get() + _used, SUMMARY_LENGTH,
+                                  "[%llu logs dropped, terminal too slow]\n", drops);
+      _used += static_cast<std::size_t>(n > 0 ? n : 0);
+      _pending_drops = 0;
+   }
+
+   /**
+    * Writes data completely, waits if output is non-blocking and full
+    *
+    * @param[in] data pointer to data
+    * @param[in] size bytes of data
+    */
+   void writeAll(const char* data, std::size_t size)
+   {
+      while(size)
+      {
+         const ssize_t n = ::write(_fd, data, size);
+         if(n < 0)
+         {
+            if(errno == EINTR)
+            {
+               continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+               struct pollfd pfd = {_fd, POLLOUT, 0};
+               ::poll(&pfd, 1, 100);
+               continue;
+            }
+            return; // output closed, drop batch
+         }
+         data += n;
+         size -= static_cast<std::size_t>(n);
+      }
+   }
+
+   /**
+    * Index of log level for color tables
+    *
+    * @param[in] level log level
+    * @return index, 0 for unknown levels
+    */
+   static std::size_t index(Log::Log level)
+   {
+      switch(level)
+      {
+         case Log::INFO: return 1;
+         case Log::DEBUG: return 2;
+         case Log::WARN: return 3;
+         case Log::ERROR: return 4;
+         default: return 0;
+      }
+   }
+
+   int _fd;                                 ///< output
+   std::size_t _capacity;                   ///< size of each buffer
+   bool _colors;                            ///< colors enabled
+   bool _block = false;                     ///< wait if buffer is full
+   std::string _prefix[5];                  ///< escape sequences per level
+   std::string _suffix;                     ///< escape sequence after log
+   const std::string _empty;                ///< no escape sequence
+   std::unique_ptr<char[]> _front;          ///< buffer filled by producers
+   std::unique_ptr<char[]> _back;           ///< buffer written by thread
+   std::size_t _used            = 0;        ///< filled bytes of _front
+   bool _writing                = false;    ///< thread writes _back
+   bool _stop                   = false;    ///< stops thread
+   std::uint64_t _pending_drops = 0;        ///< drops not summarized yet
+   std::atomic<std::uint64_t> _dropped{0};  ///< all dropped logs
+   std::atomic<std::uint64_t> _stalls{0};   ///< logs which waited for space
+   std::atomic<std::uint64_t> _stall_ns{0}; ///< [ns] waited for space
+   std::thread _thread;                     ///< writes batches
+   std::mutex _mutex;                       ///< protects all members above
+   std::condition_variable _cv;             ///< wakes thread
+   std::condition_variable _space;          ///< wakes producers and flush()
+};
+
+} // namespace evo
+
+#endif /* EVOCONSOLESINK_H_ */
@@ -0,0 +1,294 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVODEDUPLICATOR_H_
+#define EVODEDUPLICATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include "evo_logger/log/Callsite.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/time/TimeFormatter.h"
+
+namespace evo {
+
+/**
+ * @brief Collapses identical consecutive messages per log level and call site
+ *
+ * Every level has SITES slots, a call site is mapped to one of them by its
+ * address (logs without call site use the first). Only a hash of the last message
+ * of a slot (with length and call site) and its first PREFIX bytes are kept. A
+ * message equal to the last one of its slot is dropped and counted, so call sites
+ * alternating their messages are collapsed each. Call sites sharing a slot
+ * compare against each other, alternating messages of them are not collapsed.
+ *
+ * The run of repeats is reported as one summary ("last message repeated N times
+ * (first .., last ..): <first bytes>") when a different message arrives in its
+ * slot, with the next repeat after the max interval, by expire() once the run is
+ * older than the max interval or on flush().
+ *
+ * Hash and count of a slot are packed into one atomic word and updated with a
+ * compare and swap, so logging threads do not lock. Timestamps and first bytes of
+ * a run are stored relaxed after the swap, a summary racing with a change of the
+ * message may show the first bytes or times of another message.
+ *
+ * @author MSC
+ */
+class Deduplicator
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] max_interval [s] a run of repeats is reported at least this often
+    */
+   explicit Deduplicator(const double max_interval = 1.0) :
+       _max_interval(static_cast<std::int64_t>(max_interval * 1e9))
+   {
+   }
+
+   /**
+    * Proves if message repeats the last message of its level and call site
+    *
+    * @param[in]  level   log level of message
+    * @param[in]  site    call site of message, may be nullptr
+    * @param[in]  text    pointer to message
+    * @param[in]  len     length of message
+    * @param[in]  ns      timestamp [ns] of message
+    * @param[out] summary summary of ended run of repeats, to be logged before the
+    * message, empty if none ended
+    * @return true if message is a repeat and has to be dropped
+    */
+   bool repeated(Log::Log level, const Callsite* site, const char* text,
+                 const std::size_t len, const std::int64_t ns, std::string& summary)
+   {
+      const std::uint64_t tag = Deduplicator::tag(site, text, len);
+      summary.clear();
+
+      Slot& slot          = _slots[Deduplicator::index(level, site)];
+      std::uint64_t state = slot.state.load(std::memory_order_relaxed);
+      while((state & ~COUNT) == tag)
+      {
+         const std::uint64_t count = (state & COUNT) + 1;
+         const bool report =
+             count == COUNT ||
+             (count > 1 &&
+              ns - slot.first.load(std::memory_order_relaxed) >= _max_interval);
+         if(slot.state.compare_exchange_weak(state, report ? tag : state + 1,
+                                             std::memory_order_relaxed))
+         {
+            if(count == 1)
+            {
+               slot.first.store(ns, std::memory_order_relaxed);
+            }
+            slot.last.store(ns, std::memory_order_relaxed);
+            if(report)
+            {
+               Deduplicator::describe(slot, count, summary);
+            }
+            return true;
+         }
+      }
+      while(!slot.state.compare_exchange_weak(state, tag, std::memory_order_relaxed))
+      {
+         if((state & ~COUNT) == tag)
+         {
+            return this->repeated(level, site, text, len, ns, summary); // same
+         }
+      }
+      if(state & COUNT)
+      {
+         Deduplicator::describe(slot, state & COUNT, summary);
+      }
+      slot.setPrefix(text, len);
+      return false;
+   }
+
+   /**
+    * Ends all runs of repeats
+    *
+    * @param[in] func called with level and summary for every slot with repeats
+    */
+   void flush(const std::function<void(Log::Log, const std::string&)>& func)
+   {
+      this->report(std::numeric_limits<std::int64_t>::max(), func);
+   }
+
+   /**
+    * Ends runs of repeats whose first repeat is older than the max interval, so a
+    * storm that stopped is reported without waiting for the next message of its
+    * slot. Slots are scanned at most every quarter of the max interval, otherwise
+    * a call costs one relaxed load.
+    *
+    * @param[in] ns   current time [ns]
+    * @param[in] func called with level and summary for every ended run
+    */
+   template<typename F>
+   void expire(const std::int64_t ns, F func)
+   {
+      std::int64_t next = _next_expire.load(std::memory_order_relaxed);
+      if(ns < next || !_next_expire.compare_exchange_strong(
+                          next, ns + _max_interval / 4, std::memory_order_relaxed))
+      {
+         return;
+      }
+      this->report(ns - _max_interval, func);
+   }
+
+ private:
+   static const std::size_t LEVELS  = 5;              ///< unknown, one per level
+   static const std::size_t SITES   = 16;             ///< slots per level
+   static const std::size_t SLOTS   = LEVELS * SITES; ///< slots of all levels
+   static const std::size_t PREFIX  = 32;             ///< bytes of message kept
+   static const std::uint64_t COUNT = 0xFFFFFF;       ///< count bits of Slot::state
+
+   /**
+    * Last message and run of repeats of one slot of a log level
+    */
+   struct Slot
+   {
+      /// hash of last message (upper 40 bits, 0 before the first message) and
+      /// repeats not reported yet (lower 24 bits)
+      std::atomic<std::uint64_t> state{0};
+      std::atomic<std::int64_t> first{0};            ///< [ns] first repeat
+      std::atomic<std::int64_t> last{0};             ///< [ns] last repeat
+      std::atomic<std::size_t> len{0};               ///< length of last message
+      std::atomic<std::uint64_t> prefix[PREFIX / 8]; ///< first bytes of message
+
+      Slot()
+      {
+         for(std::atomic<std::uint64_t>& word : prefix)
+         {
+            word.store(0, std::memory_order_relaxed);
+         }
+      }
+
+      void setPrefix(const char* text, const std::size_t n)
+      {
+         char buf[PREFIX] = {};
+         std::memcpy(buf, text, n < PREFIX ? n : static_cast<std::size_t>(PREFIX));
+         for(std::size_t i = 0; i < PREFIX / 8; i++)
+         {
+            std::uint64_t word;
+            std::memcpy(&word, buf + i * 8, 8);
+            prefix[i].store(word, std::memory_order_relaxed);
+         }
+         len.store(n, std::memory_order_relaxed);
+      }
+
+      std::string getPrefix() const
+      {
+         char buf[PREFIX];
+         for(std::size_t i = 0; i < PREFIX / 8; i++)
+         {
+            const std::uint64_t word = prefix[i].load(std::memory_order_relaxed);
+            std::memcpy(buf + i * 8, &word, 8);
+         }
+         const std::size_t n = len.load(std::memory_order_relaxed);
+         return n > PREFIX ? std::string(buf, PREFIX) + "..." : std::string(buf, n);
+      }
+   };
+
+   /**
+    * Ends runs of repeats with first repeat not after given time
+    *
+    * @param[in] before [ns] latest first repeat of reported runs
+    * @param[in] func   called with level and summary for every ended run
+    */
+   void report(const std::int64_t before,
+               const std::function<void(Log::Log, const std::string&)>& func)
+   {
+      static const Log::Log levels[] = {Log::ALL, Log::INFO, Log::DEBUG, Log::WARN,
+                                        Log::ERROR};
+      std::string summary;
+      for(std::size_t i = 0; i < SLOTS; i++)
+      {
+         Slot& slot          = _slots[i];
+         std::uint64_t state = slot.state.load(std::memory_order_relaxed);
+         while((state & COUNT) &&
+               slot.first.load(std::memory_order_relaxed) <= before &&
+               !slot.state.compare_exchange_weak(state, state & ~COUNT,
+                                                 std::memory_order_relaxed))
+         {
+         }
+         if((state & COUNT) && slot.first.load(std::memory_order_relaxed) <= before)
+         {
+            Deduplicator::describe(slot, state & COUNT, summary);
+            func(levels[i / SITES], summary);
+         }
+      }
+   }
+
+   /**
+    * Builds summary of run of repeats
+    *
+    * @param[in]  slot    slot with repeats
+    * @param[in]  count   repeats
+    * @param[out] summary summary message
+    */
+   static void describe(const Slot& slot, const std::uint64_t count,
+                        std::string& summary)
+   {
+      summary = "last message repeated " + std::to_string(count) + " times (first " +
+                TimeFormatter::toString(slot.first.load(std::memory_order_relaxed)) +
+                ", last " +
+                TimeFormatter::toString(slot.last.load(std::memory_order_relaxed)) +
+                "): " + slot.getPrefix();
+   }
+
+   /**
+    * FNV-1a hash of message, its length and call site in the upper 40 bits, never
+    * 0
+    */
+   static std::uint64_t tag(const Callsite* site, const char* text,
+                            const std::size_t len)
+   {
+      std::uint64_t hash = 14695981039346656037ull;
+      for(std::size_t i = 0; i < len; i++)
+      {
+         hash = (hash ^ static_cast<unsigned char>(text[i])) * 1099511628211ull;
+      }
+      hash = (hash ^ static_cast<std::uint64_t>(len)) * 1099511628211ull;
+      hash = (hash ^ reinterpret_cast<std::uintptr_t>(site)) * 1099511628211ull;
+      hash &= ~COUNT;
+      return hash ? hash : COUNT + 1;
+   }
+
+   /**
+    * Index of slot of log level and call site in _slots
+    *
+    * @param[in] level log level
+    * @param[in] site  call site, may be nullptr
+    * @return index, first SITES slots for unknown levels
+    */
+   static std::size_t index(Log::Log level, const Callsite* site)
+   {
+      std::size_t base = 0;
+      switch(level)
+      {
+         case Log::INFO: base = 1; break;
+         case Log::DEBUG: base = 2; break;
+         case Log::WARN: base = 3; break;
+         case Log::ERROR: base = 4; break;
+         default: break;
+      }
+      // Fibonacci hashing, call sites are static objects close to each other
+      const std::uint64_t addr = reinterpret_cast<std::uintptr_t>(site);
+      return base * SITES + ((addr * 0x9E3779B97F4A7C15ull) >> 32) % SITES;
+   }
+
+   std::int64_t _max_interval;                ///< [ns] runs are reported this often
+   std::atomic<std::int64_t> _next_expire{0}; ///< [ns] next scan of expire()
+   Slot _slots[SLOTS];                        ///< last message per level, call site
+};
+
+} // namespace evo
+
+#endif /* EVODEDUPLICATOR_H_ */
@@ -0,0 +1,400 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOENCODER_H_
+#define EVOENCODER_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "evo_logger/log/Field.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/time/TimeFormatter.h"
+
+namespace evo {
+
+namespace LineFormat {
+/**
+ * Output format of a sink, see Sink::setFormat()
+ */
+enum LineFormat : int
+{
+   TEXT   = 0, ///< "[time]-[LEVEL]  message key=value" like the log file
+   JSON   = 1, ///< one JSON object per line
+   LOGFMT = 2  ///< ts=.. level=.. msg=".." key=value
+};
+} // namespace LineFormat
+
+/**
+ * @brief Encodes logs and their fields as text, JSON or logfmt lines
+ *
+ * The encoders append directly to the output (std::string or FormatBuffer) with a
+ * single pass over the fields. Integers, durations and doubles with up to 9
+ * decimals are converted by hand, other doubles with snprintf. Output examples
+ * for a WARN log "slow" with fields {"id", 7} and {"took",
+ * std::chrono::milliseconds(12)}:
+ *
+ * @code
+ * [20190304_12-00-00.123]-[WARN ]  slow id=7 took=12ms
+ * {"ts":"20190304_12-00-00.123","level":"WARN","msg":"slow","id":7,"took":0.012}
+ * ts=20190304_12-00-00.123 level=WARN msg=slow id=7 took=12ms
+ * @endcode
+ *
+ * Durations are written as seconds in JSON and with unit (ns, us, ms, s) else.
+ * Non finite doubles are written as null in JSON.
+ *
+ * @author MSC
+ */
+class Encoder
+{
+ public:
+   /**
+    * Encodes one log, previous content of out is replaced
+    *
+    * @param[out] out    encoded line without line break
+    * @param[in]  format output format
+    * @param[in]  ns     timestamp of log as nanoseconds since epoch
+    * @param[in]  level  log level of log
+    * @param[in]  text   pointer to log message, for TEXT including the fields
+    * @param[in]  len    length of log message
+    * @param[in]  where  location "file:line", may be nullptr
+    * @param[in]  fields fields of structured log, may be nullptr
+    */
+   static void encode(std::string& out, const LineFormat::LineFormat format,
+                      const std::int64_t ns, Log::Log level, const char* text,
+                      const std::size_t len, const char* where,
+                      const FieldRange* fields)
+   {
+      if(format == LineFormat::TEXT)
+      {
+         LogObj::parse(out, ns, level, text, len, where);
+         return;
+      }
+      const std::size_t msg_len = fields ? fields->msg_len : len;
+      out.clear();
+      out.reserve(len + 64 + (fields ? fields->size * 24 : 0));
+
+      char time[TimeFormatter::MAX_LENGTH];
+      const std::size_t time_len =
+          TimeFormatter::format(time, ns, TimeFormatter::getPrecision());
+      const std::string& level_str = LEVEL_STR[static_cast<LogType>(level)];
+      std::size_t level_len        = level_str.size();
+      while(level_len && level_str[level_len - 1] == ' ')
+      {
+         level_len--;
+      }
+
+      if(format == LineFormat::JSON)
+      {
+         out.append("{\"ts\":\"", 7);
+         out.append(time, time_len);
+         out.append("\",\"level\":\"", 11);
+         out.append(level_str.data(), level_len);
+         out.append("\"", 1);
+         if(where)
+         {
+            out.append(",\"where\":", 9);
+            Encoder::jsonString(out, where, std::strlen(where));
+         }
+         out.append(",\"msg\":", 7);
+         Encoder::jsonString(out, text, msg_len);
+         for(std::size_t i = 0; fields && i < fields->size; i++)
+         {
+            const Field& field = fields->data[i];
+            out.append(",", 1);
+            Encoder::jsonString(out, field.key(), std::strlen(field.key()));
+            out.append(":", 1);
+            Encoder::jsonValue(out, field);
+         }
+         out.append("}", 1);
+         return;
+      }
+
+      out.append("ts=", 3);
+      out.append(time, time_len);
+      out.append(" level=", 7);
+      out.append(level_str.data(), level_len);
+      if(where)
+      {
+         out.append(" where=", 7);
+         Encoder::logfmtString(out, where, std::strlen(where));
+      }
+      out.append(" msg=", 5);
+      Encoder::logfmtString(out, text, msg_len);
+      if(fields)
+      {
+         Encoder::appendFields(out, fields->data, fields->size);
+      }
+   }
+
+   /**
+    * Appends fields as logfmt (" key=value" each), used for the text of
+    * structured logs on terminal and in the log file
+    *
+    * @param[out] out    output with append(const char*, std::size_t)
+    * @param[in]  fields first field
+    * @param[in]  size   number of fields
+    */
+   template<typename Out>
+   static void appendFields(Out& out, const Field* fields, const std::size_t size)
+   {
+      for(std::size_t i = 0; i < size; i++)
+      {
+         const Field& field = fields[i];
+         out.append(" ", 1);
+         out.append(field.key(), std::strlen(field.key()));
+         out.append("=", 1);
+         Encoder::logfmtValue(out, field);
+      }
+   }
+
+ private:
+   template<typename Out>
+   static void logfmtValue(Out& out, const Field& field)
+   {
+      switch(field.type())
+      {
+         case FieldType::INT: Encoder::appendInt(out, field.asInt()); break;
+         case FieldType::UINT: Encoder::appendUInt(out, field.asUInt()); break;
+         case FieldType::DOUBLE: Encoder::appendDouble(out, field.asDouble()); break;
+         case FieldType::BOOL:
+            field.asBool() ? out.append("true", 4) : out.append("false", 5);
+            break;
+         case FieldType::STRING:
+            Encoder::logfmtString(out, field.data(), field.size());
+            break;
+         case FieldType::DURATION:
+            Encoder::appendDuration(out, field.asInt());
+            break;
+      }
+   }
+
+   template<typename Out>
+   static void jsonValue(Out& out, const Field& field)
+   {
+      switch(field.type())
+      {
+         case FieldType::INT: Encoder::appendInt(out, field.asInt()); break;
+         case FieldType::UINT: Encoder::appendUInt(out, field.asUInt()); break;
+         case FieldType::DOUBLE:
+            if(std::isfinite(field.asDouble()))
+            {
+               Encoder::appendDouble(out, field.asDouble());
+            }
+            else
+            {
+               out.append("null", 4);
+            }
+            break;
+         case FieldType::BOOL:
+            field.asBool() ? out.append("true", 4) : out.append("false", 5);
+            break;
+         case FieldType::STRING:
+            Encoder::jsonString(out, field.data(), field.size());
+            break;
+         case FieldType::DURATION: // seconds
+         {
+            char buf[32];
+            out.append(buf, Encoder::decimal(buf, field.asInt(), 9));
+            break;
+         }
+      }
+   }
+
+   /**
+    * Appends string in quotes with JSON escapes
+    */
+   template<typename Out>
+   static void jsonString(Out& out, const char* str, const std::size_t len)
+   {
+      static const char* hex = "0123456789abcdef";
+      out.append("\"", 1);
+      std::size_t start = 0;
+      for(std::size_t i = 0; i < len; i++)
+      {
+         const unsigned char c = static_cast<unsigned char>(str[i]);
+         if(c >= 0x20 && c != '"' && c != '\\')
+         {
+            continue;
+         }
+         out.append(str + start, i - start);
+         start = i + 1;
+         switch(c)
+         {
+            case '"': out.append("\\\"", 2); break;
+            case '\\': out.append("\\\\", 2); break;
+            case '\n': out.append("\\n", 2); break;
+            case '\r': out.append("\\r", 2); break;
+            case '\t': out.append("\\t", 2); break;
+            default:
+            {
+               const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 15]};
+               out.append(esc, 6);
+            }
+         }
+      }
+      out.append(str + start, len - start);
+      out.append("\"", 1);
+   }
+
+   /**
+    * Appends string, quoted and escaped only if it is empty or contains spaces,
+    * '=', quotes or control chars
+    */
+   template<typename Out>
+   static void logfmtString(Out& out, const char* str, const std::size_t len)
+   {
+      bool quote = !len;
+      for(std::size_t i = 0; i < len && !quote; i++)
+      {
+         const unsigned char c = static_cast<unsigned char>(str[i]);
+         quote = c <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7f;
+      }
+      if(quote)
+      {
+         Encoder::jsonString(out, str, len);
+      }
+      else
+      {
+         out.append(str, len);
+      }
+   }
+
+   template<typename Out>
+   static void appendUInt(Out& out, std::uint64_t value)
+   {
+      char buf[20];
+      std::size_t pos = sizeof(buf);
+      do
+      {
+         buf[--pos] = static_cast<char>('0' + value % 10);
+         value /= 10;
+      } while(value);
+      out.append(buf + pos, sizeof(buf) - pos);
+   }
+
+   template<typename Out>
+   static void appendInt(Out& out, const std::int64_t value)
+   {
+      if(value < 0)
+      {
+         out.append("-", 1);
+         Encoder::appendUInt(out, 0ull - static_cast<std::uint64_t>(value));
+         return;
+      }
+      Encoder::appendUInt(out, static_cast<std::uint64_t>(value));
+   }
+
+   /**
+    * Appends double, values with up to 9 decimals (e.g. 0.25) are converted by hand,
+    * others with the shortest of %.15g and %.17g which reads back to the same value
+    */
+   template<typename Out>
+   static void appendDouble(Out& out, const double value)
+   {
+      char buf[32];
+      if(std::fabs(value) < 1e15)
+      {
+         double pow = 1.0;
+         for(unsigned int digits = 0; digits <= 9; digits++, pow *= 10.0)
+         {
+            const double scaled = value * pow;
+            if(scaled != std::floor(scaled) || std::fabs(scaled) >= 9e15)
+            {
+               continue;
+            }
+            const std::size_t n = Encoder::decimal(
+                buf, static_cast<std::int64_t>(scaled), digits);
+            buf[n] = '\0';
+            if(std::strtod(buf, nullptr) == value)
+            {
+               out.append(buf, n);
+               return;
+            }
+            break;
+         }
+      }
+      int n = std::snprintf(buf, sizeof(buf), "%.15g", value);
+      if(std::isfinite(value) && std::strtod(buf, nullptr) != value)
+      {
+         n = std::snprintf(buf, sizeof(buf), "%.17g", value);
+      }
+      out.append(buf, static_cast<std::size_t>(n));
+   }
+
+   /**
+    * Appends duration with largest unit keeping the value >= 1, e.g. 1.5ms
+    */
+   template<typename Out>
+   static void appendDuration(Out& out, const std::int64_t ns)
+   {
+      const std::int64_t mag = ns < 0 ? -ns : ns;
+      // clang-format off
+      const unsigned int digits = mag < 1000       ? 0 :
+                                  mag < 1000000    ? 3 :
+                                  mag < 1000000000 ? 6 :
+                                                     9;
+      // clang-format on
+      static const char* units[] = {"ns", "", "", "us", "", "", "ms", "", "", "s"};
+      char buf[32];
+      const std::size_t n = Encoder::decimal(buf, ns, digits);
+      out.append(buf, n);
+      out.append(units[digits], std::strlen(units[digits]));
+   }
+
+   /**
+    * Writes value / 10^digits as exact decimal without trailing zeros
+    *
+    * @param[out] buf    buffer with at least 32 chars
+    * @param[in]  value  scaled value
+    * @param[in]  digits number of decimals of value, at most 18
+    * @return number of chars written
+    */
+   static std::size_t decimal(char* buf, const std::int64_t value,
+                              unsigned int digits)
+   {
+      std::uint64_t mag =
+          value < 0 ? 0ull - static_cast<std::uint64_t>(value)
+                    : static_cast<std::uint64_t>(value);
+      while(digits && mag % 10 == 0) // trailing zeros
+      {
+         mag /= 10;
+         digits--;
+      }
+      char tmp[24];
+      std::size_t len = 0;
+      do
+      {
+         tmp[len++] = static_cast<char>('0' + mag % 10);
+         mag /= 10;
+      } while(mag);
+      while(len <= digits) // leading zeros of fraction
+      {
+         tmp[len++] = '0';
+      }
+      std::size_t pos = 0;
+      if(value < 0)
+      {
+         buf[pos++] = '-';
+      }
+      for(std::size_t i = len; i > 0; i--)
+      {
+         if(i == digits && digits)
+         {
+            buf[pos++] = '.';
+         }
+         buf[pos++] = tmp[i - 1];
+      }
+      return pos;
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOENCODER_H_ */
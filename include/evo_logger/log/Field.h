@@ -0,0 +1,154 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOFIELD_H_
+#define EVOFIELD_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace evo {
+
+namespace FieldType {
+/**
+ * Type of value of a Field
+ */
+enum FieldType
+{
+   INT,     ///< signed integer
+   UINT,    ///< unsigned integer
+   DOUBLE,  ///< floating point
+   BOOL,    ///< true or false
+   STRING,  ///< string, not copied
+   DURATION ///< std::chrono::duration, stored as nanoseconds
+};
+} // namespace FieldType
+
+/**
+ * @brief Typed key/value pair attached to a structured log, see
+ * Logger::log(level, msg, fields)
+ *
+ * A Field only references its key and string values, nothing is copied or
+ * allocated. It is meant to live in an initializer list for the duration of one
+ * log call:
+ *
+ * @code
+ * evo::log::info("connected", {{"host", host}, {"port", 8080},
+ *                              {"latency", std::chrono::microseconds(350)}});
+ * @endcode
+ *
+ * Keys should be identifiers (no spaces, '=' or quotes), they are written as
+ * given in logfmt output.
+ *
+ * @author MSC
+ */
+class Field
+{
+ public:
+   template<typename T,
+            typename std::enable_if<std::is_integral<T>::value &&
+                                        std::is_signed<T>::value,
+                                    int>::type = 0>
+   Field(const char* key, const T value) : _key(key), _type(FieldType::INT)
+   {
+      _value.i = static_cast<std::int64_t>(value);
+   }
+
+   template<typename T,
+            typename std::enable_if<std::is_integral<T>::value &&
+                                        std::is_unsigned<T>::value &&
+                                        !std::is_same<T, bool>::value,
+                                    int>::type = 0>
+   Field(const char* key, const T value) : _key(key), _type(FieldType::UINT)
+   {
+      _value.u = static_cast<std::uint64_t>(value);
+   }
+
+   template<typename T,
+            typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+   Field(const char* key, const T value) : _key(key), _type(FieldType::DOUBLE)
+   {
+      _value.d = static_cast<double>(value);
+   }
+
+   Field(const char* key, const bool value) : _key(key), _type(FieldType::BOOL)
+   {
+      _value.b = value;
+   }
+
+   Field(const char* key, const char* value) : _key(key), _type(FieldType::STRING)
+   {
+      _value.s.ptr = value ? value : "(null)";
+      _value.s.len = std::strlen(_value.s.ptr);
+   }
+
+   Field(const char* key, const std::string& value) :
+       _key(key), _type(FieldType::STRING)
+   {
+      _value.s.ptr = value.data();
+      _value.s.len = value.size();
+   }
+
+   template<typename Rep, typename Period>
+   Field(const char* key, const std::chrono::duration<Rep, Period> value) :
+       _key(key), _type(FieldType::DURATION)
+   {
+      _value.i =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(value).count();
+   }
+
+   const char* key() const { return _key; }
+
+   FieldType::FieldType type() const { return _type; }
+
+   /**
+    * Getter for value of INT fields and nanoseconds of DURATION fields
+    */
+   std::int64_t asInt() const { return _value.i; }
+
+   std::uint64_t asUInt() const { return _value.u; }
+
+   double asDouble() const { return _value.d; }
+
+   bool asBool() const { return _value.b; }
+
+   const char* data() const { return _value.s.ptr; }
+
+   std::size_t size() const { return _value.s.len; }
+
+ private:
+   const char* _key;          ///< key
+   FieldType::FieldType _type; ///< type of value
+   union
+   {
+      std::int64_t i;  ///< INT, DURATION [ns]
+      std::uint64_t u; ///< UINT
+      double d;        ///< DOUBLE
+      bool b;          ///< BOOL
+      struct
+      {
+         const char* ptr;
+         std::size_t len;
+      } s; ///< STRING
+   } _value; ///< value
+};
+
+/**
+ * Fields of one structured log, passed from Logger to the encoders of the sinks
+ */
+struct FieldRange
+{
+   const Field* data;   ///< first field
+   std::size_t size;    ///< number of fields
+   std::size_t msg_len; ///< length of message without fields appended as logfmt
+};
+
+} // namespace evo
+
+#endif /* EVOFIELD_H_ */
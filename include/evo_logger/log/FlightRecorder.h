@@ -0,0 +1,314 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOFLIGHTRECORDER_H_
+#define EVOFLIGHTRECORDER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogType.h"
+
+namespace evo {
+
+namespace RingFormat {
+static const char MAGIC[8] = {'E', 'V', 'O', 'R', 'I', 'N', 'G', '1'}; ///< header
+static const std::uint32_t ENTRY = 0x52564545; ///< magic of entry ("EEVR")
+static const std::size_t DATA    = 64;         ///< offset of ring in file
+
+/**
+ * Header at start of ring file
+ */
+struct Header
+{
+   char magic[8];                       ///< MAGIC
+   std::uint64_t capacity;              ///< bytes of ring
+   std::atomic<std::uint64_t> head;     ///< end of last complete entry (total bytes)
+   std::atomic<std::uint64_t> reserved; ///< end of entry being written
+};
+static_assert(sizeof(Header) == 32, "FlightReader expects packed ring header");
+
+/**
+ * Header of one entry, followed by message (8 byte aligned) and total size
+ * (uint64) as trailer, so the ring can be walked backwards from head
+ */
+struct Entry
+{
+   std::uint32_t magic; ///< ENTRY
+   std::uint32_t level; ///< log level
+   std::int64_t ns;     ///< timestamp [ns] since epoch
+   std::uint32_t size;  ///< length of message
+   std::uint32_t total; ///< bytes of entry including trailer
+};
+
+/**
+ * Bytes needed for entry
+ *
+ * @param[in] len length of message
+ * @return bytes of header, message (8 byte aligned) and trailer
+ */
+inline std::uint64_t footprint(const std::size_t len)
+{
+   return ((sizeof(Entry) + len + 7) & ~static_cast<std::uint64_t>(7)) +
+          sizeof(std::uint64_t);
+}
+} // namespace RingFormat
+
+/**
+ * @brief Fixed size ring of the latest logs in a memory mapped file
+ *
+ * Every log is copied into a ring in "<log file>.ring" (MAP_SHARED), so the
+ * latest logs are in the page cache even if the process is killed before they
+ * were written to the log file. A clean shutdown removes the file, a leftover
+ * ring is read with FlightReader or the evo_log_recover tool. Enable it with
+ * Logger::enableFlightRecorder().
+ *
+ * @note survives process crashes, not power loss or kernel crashes
+ *
+ * @author MSC
+ */
+class FlightRecorder
+{
+ public:
+   /**
+    * Constructor, creates and maps file, see isOpen()
+    *
+    * @param[in] file path of ring file
+    * @param[in] size bytes of ring (rounded up to 4 KiB)
+    */
+   FlightRecorder(const std::string& file, const std::size_t size = 8 << 20) :
+       _file(file)
+   {
+      _capacity       = (static_cast<std::uint64_t>(size) + 4095) & ~4095ull;
+      const off_t len = static_cast<off_t>(RingFormat::DATA + _capacity);
+      const int fd    = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                               0666);
+      if(fd < 0)
+      {
+         this->setError("open");
+         return;
+      }
+      // allocate blocks, writes into a sparse mapping could fail with SIGBUS
+      const int err = ::posix_fallocate(fd, 0, len);
+      if(err != 0)
+      {
+         errno = err;
+         this->setError("fallocate");
+         ::close(fd);
+         return;
+      }
+      void* map = ::mmap(nullptr, static_cast<std::size_t>(len),
+                         PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(map == MAP_FAILED)
+      {
+         this->setError("mmap");
+         return;
+      }
+      _map  = static_cast<char*>(map);
+      _hdr  = reinterpret_cast<RingFormat::Header*>(_map);
+      _data = _map + RingFormat::DATA;
+      std::memcpy(_hdr->magic, RingFormat::MAGIC, sizeof(RingFormat::MAGIC));
+      _hdr->capacity = _capacity;
+      _hdr->head.store(0, std::memory_order_relaxed);
+      _hdr->reserved.store(0, std::memory_order_release);
+   }
+
+   FlightRecorder(const FlightRecorder&) = delete;
+   FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+   /**
+    * Destructor unmaps ring and removes file, logs are in the log file after a
+    * clean shutdown
+    */
+   ~FlightRecorder()
+   {
+      if(_map)
+      {
+         ::munmap(_map, RingFormat::DATA + _capacity);
+         ::unlink(_file.c_str());
+      }
+   }
+
+   /**
+    * Proves if ring is usable
+    *
+    * @return true if file is mapped, else see lastError()
+    */
+   bool isOpen() const { return _map != nullptr; }
+
+   /**
+    * Getter for reason of failed open
+    *
+    * @return error message
+    */
+   const std::string& lastError() const { return _error; }
+
+   /**
+    * Copies log into ring, overwrites oldest logs, too long messages are cut
+    *
+    * @param[in] ns    timestamp [ns] since epoch
+    * @param[in] level log level
+    * @param[in] text  pointer to message
+    * @param[in] len   length of message
+    */
+   void append(const std::int64_t ns, Log::Log level, const char* text,
+               std::size_t len)
+   {
+      if(RingFormat::footprint(len) > _capacity)
+      {
+         len = static_cast<std::size_t>(_capacity - RingFormat::footprint(0));
+      }
+      const std::uint64_t total     = RingFormat::footprint(len);
+      const RingFormat::Entry entry = {
+          RingFormat::ENTRY, static_cast<std::uint32_t>(level), ns,
+          static_cast<std::uint32_t>(len), static_cast<std::uint32_t>(total)};
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      const std::uint64_t pos = _hdr->head.load(std::memory_order_relaxed);
+      // mark overwritten range before writing into it
+      _hdr->reserved.store(pos + total, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      this->put(pos, &entry, sizeof(entry));
+      this->put(pos + sizeof(entry), text, len);
+      this->put(pos + total - sizeof(total), &total, sizeof(total));
+      _hdr->head.store(pos + total, std::memory_order_release);
+   }
+
+ private:
+   /**
+    * Copies data to ring position, wraps at end of ring
+    */
+   void put(const std::uint64_t pos, const void* data, const std::size_t len)
+   {
+      const std::size_t offset = static_cast<std::size_t>(pos % _capacity);
+      const std::size_t first  = std::min<std::size_t>(len, _capacity - offset);
+      std::memcpy(_data + offset, data, first);
+      std::memcpy(_data, static_cast<const char*>(data) + first, len - first);
+   }
+
+   /**
+    * Sets _error from errno
+    *
+    * @param[in] op name of failed operation
+    */
+   void setError(const char* op)
+   {
+      _error = std::string(op) + " " + _file + ": " + std::strerror(errno);
+   }
+
+   std::string _file;                  ///< ring file
+   std::string _error;                 ///< reason of failed open
+   std::uint64_t _capacity  = 0;       ///< bytes of ring
+   char* _map               = nullptr; ///< mapped file
+   RingFormat::Header* _hdr = nullptr; ///< header in _map
+   char* _data              = nullptr; ///< ring in _map
+   std::mutex _mutex;                  ///< serializes writers
+};
+
+/**
+ * @brief Reads logs from a ring file left by FlightRecorder
+ *
+ * @author MSC
+ */
+class FlightReader
+{
+ public:
+   /**
+    * Reads the latest logs of ring file and calls func for them, oldest first
+    *
+    * @param[in] file  ring file
+    * @param[in] count max number of logs (latest), 0 for all
+    * @param[in] func  called with log
+    * @return false if file could not be read or is no ring file
+    */
+   static bool read(const std::string& file, const std::size_t count,
+                    const std::function<void(const LogObj&)>& func)
+   {
+      std::ifstream in(file.c_str(), std::ios::binary);
+      if(!in)
+      {
+         return false;
+      }
+      std::vector<char> data((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+      if(data.size() < RingFormat::DATA ||
+         std::memcmp(data.data(), RingFormat::MAGIC, sizeof(RingFormat::MAGIC)))
+      {
+         return false;
+      }
+      std::uint64_t capacity = 0, head = 0, reserved = 0;
+      std::memcpy(&capacity, &data[8], sizeof(capacity));
+      std::memcpy(&head, &data[16], sizeof(head));
+      std::memcpy(&reserved, &data[24], sizeof(reserved));
+      if(!capacity || data.size() < RingFormat::DATA + capacity || reserved < head)
+      {
+         return false;
+      }
+      const char* ring = &data[RingFormat::DATA];
+
+      // walk backwards from head, bytes before reserved - capacity are overwritten
+      const std::uint64_t low = reserved > capacity ? reserved - capacity : 0;
+      std::vector<LogObj> logs;
+      std::uint64_t pos = head;
+      while(pos - low >= RingFormat::footprint(0) && (!count || logs.size() < count))
+      {
+         std::uint64_t total = 0;
+         get(ring, capacity, pos - sizeof(total), &total, sizeof(total));
+         if(total < RingFormat::footprint(0) || total > pos - low || total % 8)
+         {
+            break;
+         }
+         RingFormat::Entry entry;
+         get(ring, capacity, pos - total, &entry, sizeof(entry));
+         if(entry.magic != RingFormat::ENTRY || entry.total != total ||
+            RingFormat::footprint(entry.size) != total)
+         {
+            break;
+         }
+         std::string text(entry.size, '\0');
+         get(ring, capacity, pos - total + sizeof(entry), &text[0], entry.size);
+         logs.push_back(LogObj{Time::fromNSec(entry.ns),
+                               static_cast<Log::Log>(entry.level), std::move(text)});
+         pos -= total;
+      }
+
+      for(auto it = logs.rbegin(); it != logs.rend(); ++it)
+      {
+         func(*it);
+      }
+      return true;
+   }
+
+ private:
+   /**
+    * Copies data from ring position, wraps at end of ring
+    */
+   static void get(const char* ring, const std::uint64_t capacity,
+                   const std::uint64_t pos, void* data, const std::size_t len)
+   {
+      const std::size_t offset = static_cast<std::size_t>(pos % capacity);
+      const std::size_t first  = std::min<std::size_t>(len, capacity - offset);
+      std::memcpy(data, ring + offset, first);
+      std::memcpy(static_cast<char*>(data) + first, ring, len - first);
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOFLIGHTRECORDER_H_ */
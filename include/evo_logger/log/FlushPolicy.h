@@ -0,0 +1,62 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOFLUSHPOLICY_H_
+#define EVOFLUSHPOLICY_H_
+
+#include <cstddef>
+
+#include "evo_logger/log/LogType.h"
+
+namespace evo {
+
+/**
+ * @brief Triggers for writing stored logs to file
+ *
+ * Stored logs are written as soon as one trigger fires, so memory stays bounded
+ * and every write handles a small batch. A value of 0 disables a trigger.
+ * Triggers fire after Logger::initialize() only. Logs before are kept in memory
+ * until they use 4 * max_bytes (4 MiB if disabled), then the Logger initializes
+ * itself with name "EVO" and writes them, a later initialize() has no effect.
+ *
+ * Following code shows usage:
+ * @code
+ * evo::FlushPolicy policy;
+ * policy.max_records = 1000;
+ * policy.flush_levels = evo::Log::ERROR | evo::Log::WARN;
+ * evo::log::get().setFlushPolicy(policy);
+ * @endcode
+ *
+ * @author MSC
+ */
+struct FlushPolicy
+{
+   std::size_t max_records = 4096;    ///< number of stored logs
+   std::size_t max_bytes   = 1 << 20; ///< bytes used by stored logs
+   double max_interval     = 5.0;     ///< [s] since last write
+   LogType flush_levels    = Log::ERROR; ///< levels written immediately
+
+   /**
+    * Proves if stored logs have to be written
+    *
+    * @param[in] records number of stored logs
+    * @param[in] bytes   bytes used by stored logs
+    * @param[in] elapsed [s] since last write
+    * @param[in] level   level of last stored log
+    * @return true if one trigger fires
+    */
+   bool due(const std::size_t records, const std::size_t bytes, const double elapsed,
+            const Log::Log level) const
+   {
+      return (max_records && records >= max_records) ||
+             (max_bytes && bytes >= max_bytes) ||
+             (max_interval > 0.0 && elapsed >= max_interval) ||
+             (static_cast<LogType>(level) & flush_levels);
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOFLUSHPOLICY_H_ */
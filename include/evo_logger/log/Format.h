@@ -0,0 +1,679 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOFORMAT_H_
+#define EVOFORMAT_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace evo {
+
+/**
+ * @brief Reusable char buffer for formatted messages
+ *
+ * The buffer only grows, clear() keeps the capacity, so formatting is allocation
+ * free once the longest message fit in. Use local() for a per-thread instance.
+ *
+ * @author MSC
+ */
+class FormatBuffer
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] capacity initial capacity in bytes
+    */
+   explicit FormatBuffer(const std::size_t capacity = 256) : _buf(capacity) {}
+
+   /**
+    * Getter for buffer of calling thread
+    *
+    * @return thread local instance
+    */
+   static FormatBuffer& local()
+   {
+      thread_local FormatBuffer buffer;
+      return buffer;
+   }
+
+   const char* data() const { return _buf.data(); }
+
+   std::size_t size() const { return _size; }
+
+   void clear() { _size = 0; }
+
+   std::string str() const { return std::string(_buf.data(), _size); }
+
+   /**
+    * Makes sure n more chars fit in
+    *
+    * @param[in] n number of chars
+    * @return pointer to end of data
+    */
+   char* reserve(const std::size_t n)
+   {
+      if(_size + n > _buf.size())
+      {
+         _buf.resize(std::max(_buf.size() * 2, _size + n));
+      }
+      return &_buf[_size];
+   }
+
+   /**
+    * Marks n chars behind end of data as used, after writing them via reserve()
+    *
+    * @param[in] n number of chars
+    */
+   void commit(const std::size_t n) { _size += n; }
+
+   void append(const char* str, const std::size_t n)
+   {
+      std::memcpy(this->reserve(n), str, n);
+      _size += n;
+   }
+
+   void append(const char c, const std::size_t n = 1)
+   {
+      std::memset(this->reserve(n), c, n);
+      _size += n;
+   }
+
+ private:
+   std::vector<char> _buf; ///< storage, only grows
+   std::size_t _size = 0;  ///< used chars
+};
+
+/**
+ * @brief Compile time check of printf-style format strings against argument types
+ *
+ * check() walks the format string in a constexpr recursion and consumes one type
+ * per conversion ('*' for width or precision consumes an integer). Used by the
+ * EVO_DEBUG/EVO_INFO/... macros via EVO_FORMAT_CHECK, the format string has to be
+ * a string literal there.
+ *
+ * Accepted types per conversion: d i u x X o c -> integer or enum, f F e E g G a A
+ * -> floating point, s -> char* or std::string, p -> pointer. %n is rejected.
+ *
+ * @note format strings are limited by the compilers constexpr depth (512 chars for
+ * GCC by default)
+ */
+template<typename... Ts>
+struct FormatCheck;
+
+/**
+ * Helpers for FormatCheck
+ */
+struct FormatTraits
+{
+   static constexpr bool isFlag(const char c)
+   {
+      return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+   }
+
+   static constexpr bool isDigit(const char c) { return c >= '0' && c <= '9'; }
+
+   static constexpr bool isLength(const char c)
+   {
+      return c == 'h' || c == 'l' || c == 'L' || c == 'q' || c == 'j' || c == 'z' ||
+             c == 't';
+   }
+
+   static constexpr const char* skipDigits(const char* f)
+   {
+      return isDigit(*f) ? skipDigits(f + 1) : f;
+   }
+
+   static constexpr bool isIntConv(const char c)
+   {
+      return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' ||
+             c == 'c';
+   }
+
+   static constexpr bool isFloatConv(const char c)
+   {
+      return c == 'f' || c == 'F' || c == 'e' || c == 'E' || c == 'g' || c == 'G' ||
+             c == 'a' || c == 'A';
+   }
+
+   template<typename T>
+   static constexpr bool isInt()
+   {
+      return std::is_integral<T>::value || std::is_enum<T>::value;
+   }
+
+   template<typename T>
+   static constexpr bool isString()
+   {
+      return std::is_same<T, const char*>::value || std::is_same<T, char*>::value ||
+             std::is_same<T, std::string>::value;
+   }
+
+   template<typename T>
+   static constexpr bool isPointer()
+   {
+      return std::is_pointer<T>::value || std::is_same<T, std::nullptr_t>::value;
+   }
+
+   template<typename T>
+   static constexpr bool accepts(const char c)
+   {
+      // clang-format off
+      return isIntConv(c)   ? isInt<T>() :
+             isFloatConv(c) ? std::is_floating_point<T>::value :
+             c == 's'       ? isString<T>() :
+             c == 'p'       ? isPointer<T>() :
+                              false;
+      // clang-format on
+   }
+};
+
+/**
+ * FormatCheck without arguments left, only %% may follow
+ */
+template<>
+struct FormatCheck<>
+{
+   static constexpr bool check(const char* f)
+   {
+      return *f == '\0' ? true
+                        : *f != '%' ? check(f + 1) : f[1] == '%' ? check(f + 2) : false;
+   }
+
+   static constexpr bool afterWidth(const char*) { return false; }
+
+   static constexpr bool length(const char*) { return false; }
+};
+
+/**
+ * FormatCheck with next argument type T
+ */
+template<typename T, typename... Ts>
+struct FormatCheck<T, Ts...>
+{
+   static constexpr bool check(const char* f)
+   {
+      return *f == '\0' ? false // too many arguments
+                        : *f != '%' ? check(f + 1)
+                                    : f[1] == '%' ? check(f + 2) : flags(f + 1);
+   }
+
+   static constexpr bool flags(const char* f)
+   {
+      return FormatTraits::isFlag(*f)
+                 ? flags(f + 1)
+                 : *f == '*' ? (FormatTraits::isInt<T>() &&
+                                FormatCheck<Ts...>::afterWidth(f + 1))
+                             : afterWidth(FormatTraits::skipDigits(f));
+   }
+
+   static constexpr bool afterWidth(const char* f)
+   {
+      return *f != '.' ? length(f)
+                       : f[1] == '*' ? (FormatTraits::isInt<T>() &&
+                                        FormatCheck<Ts...>::length(f + 2))
+                                     : length(FormatTraits::skipDigits(f + 1));
+   }
+
+   static constexpr bool length(const char* f)
+   {
+      return FormatTraits::isLength(*f)
+                 ? length(f + 1)
+                 : FormatTraits::accepts<T>(*f) && FormatCheck<Ts...>::check(f + 1);
+   }
+};
+
+/**
+ * Maps format string and argument types to FormatCheck, only used in decltype
+ */
+template<typename... Args>
+FormatCheck<typename std::decay<Args>::type...> formatCheck(const char*, const Args&...);
+
+// first macro argument, works for one argument, too
+#define EVO_FORMAT_FIRST_(...) EVO_FORMAT_FIRST_IMPL_(__VA_ARGS__, 0)
+#define EVO_FORMAT_FIRST_IMPL_(first, ...) first
+
+/**
+ * Fails to compile if the format string literal (first argument) does not match
+ * the types of the other arguments, arguments are not evaluated
+ */
+#define EVO_FORMAT_CHECK(...)                                                      \
+   static_assert(decltype(evo::formatCheck(__VA_ARGS__))::check(                   \
+                     EVO_FORMAT_FIRST_(__VA_ARGS__)),                              \
+                 "evo_logger: format string does not match argument types")
+
+/**
+ * @brief Type safe printf-style formatting into a FormatBuffer
+ *
+ * Formats in one pass without heap allocation (once the buffer is large enough).
+ * Integers, strings and chars are formatted directly, floating point and pointers
+ * with snprintf of a single conversion into the buffer. The argument is always
+ * formatted according to its real type: a conversion which does not fit the type
+ * falls back to the default conversion of the type (%d, %g, %s, %p), length
+ * modifiers are ignored.
+ *
+ * @author MSC
+ */
+class Format
+{
+ public:
+   /**
+    * Appends formatted string to buffer
+    *
+    * @param[out] out  buffer to append to
+    * @param[in]  fmt  printf-style format string
+    * @param[in]  args printf args
+    */
+   template<typename... Args>
+   static void format(FormatBuffer& out, const char* fmt, const Args&... args)
+   {
+      Spec spec;
+      formatArgs(out, fmt, spec, false, args...);
+   }
+
+   /**
+    * Formats to std::string
+    *
+    * @param[in] fmt  printf-style format string
+    * @param[in] args printf args
+    * @return formatted string
+    */
+   template<typename... Args>
+   static std::string toString(const char* fmt, const Args&... args)
+   {
+      FormatBuffer& buf = FormatBuffer::local();
+      buf.clear();
+      format(buf, fmt, args...);
+      return buf.str();
+   }
+
+ private:
+   static const int NONE = -1; ///< width or precision not given
+   static const int STAR = -2; ///< width or precision given as argument
+
+   /**
+    * Parsed conversion specification
+    */
+   struct Spec
+   {
+      bool left  = false; ///< flag '-'
+      bool plus  = false; ///< flag '+'
+      bool space = false; ///< flag ' '
+      bool alt   = false; ///< flag '#'
+      bool zero  = false; ///< flag '0'
+      int width  = NONE;  ///< minimum width
+      int prec   = NONE;  ///< precision
+      char conv  = 0;     ///< conversion char
+   };
+
+   /**
+    * Copies text until next conversion and parses it
+    *
+    * @return pointer behind conversion, nullptr if end of format string reached
+    */
+   static const char* next(FormatBuffer& out, const char* f, Spec& spec)
+   {
+      for(;;)
+      {
+         const char* pct = std::strchr(f, '%');
+         if(!pct)
+         {
+            out.append(f, std::strlen(f));
+            return nullptr;
+         }
+         out.append(f, static_cast<std::size_t>(pct - f));
+         f = pct + 1;
+         if(*f == '%')
+         {
+            out.append('%');
+            f++;
+            continue;
+         }
+         break;
+      }
+
+      spec = Spec();
+      for(;; f++)
+      {
+         if(*f == '-') spec.left = true;
+         else if(*f == '+') spec.plus = true;
+         else if(*f == ' ') spec.space = true;
+         else if(*f == '#') spec.alt = true;
+         else if(*f == '0') spec.zero = true;
+         else break;
+      }
+      f = number(f, spec.width);
+      if(*f == '.')
+      {
+         f = number(f + 1, spec.prec);
+         if(spec.prec == NONE)
+         {
+            spec.prec = 0;
+         }
+      }
+      while(FormatTraits::isLength(*f))
+      {
+         f++;
+      }
+      if(*f == '\0')
+      {
+         return nullptr;
+      }
+      spec.conv = *f;
+      return f + 1;
+   }
+
+   static const char* number(const char* f, int& value)
+   {
+      if(*f == '*')
+      {
+         value = STAR;
+         return f + 1;
+      }
+      if(!FormatTraits::isDigit(*f))
+      {
+         return f;
+      }
+      value = 0;
+      while(FormatTraits::isDigit(*f))
+      {
+         value = value * 10 + (*f++ - '0');
+      }
+      return f;
+   }
+
+   /**
+    * End of recursion, copies rest of format string
+    */
+   static void formatArgs(FormatBuffer& out, const char* f, Spec& spec, bool pending)
+   {
+      if(pending)
+      {
+         out.append("(missing)", 9);
+      }
+      while(f && (f = next(out, f, spec)))
+      {
+         out.append("(missing)", 9);
+      }
+   }
+
+   template<typename T, typename... Args>
+   static void formatArgs(FormatBuffer& out, const char* f, Spec& spec, bool pending,
+                          const T& arg, const Args&... args)
+   {
+      if(!pending)
+      {
+         f = f ? next(out, f, spec) : nullptr;
+         if(!f)
+         {
+            return; // too many arguments
+         }
+      }
+      if(spec.width == STAR)
+      {
+         spec.width = starValue(arg);
+         if(spec.width < 0)
+         {
+            spec.left  = true;
+            spec.width = -spec.width;
+         }
+         formatArgs(out, f, spec, true, args...);
+         return;
+      }
+      if(spec.prec == STAR)
+      {
+         spec.prec = starValue(arg);
+         if(spec.prec < 0)
+         {
+            spec.prec = NONE;
+         }
+         formatArgs(out, f, spec, true, args...);
+         return;
+      }
+      formatArg(out, spec, arg);
+      formatArgs(out, f, spec, false, args...);
+   }
+
+   template<typename T>
+   static typename std::enable_if<FormatTraits::isInt<T>(), int>::type
+   starValue(const T& arg)
+   {
+      return static_cast<int>(arg);
+   }
+
+   template<typename T>
+   static typename std::enable_if<!FormatTraits::isInt<T>(), int>::type
+   starValue(const T&)
+   {
+      return 0;
+   }
+
+   // integers, chars, bool and enums
+   template<typename T>
+   static typename std::enable_if<FormatTraits::isInt<T>()>::type
+   formatArg(FormatBuffer& out, const Spec& spec, const T& arg)
+   {
+      using Int = typename std::conditional<std::is_enum<T>::value, long long, T>::type;
+      using U   = typename std::make_unsigned<
+          typename std::conditional<std::is_same<Int, bool>::value, unsigned char,
+                                    Int>::type>::type;
+      const Int value = static_cast<Int>(arg);
+      switch(spec.conv)
+      {
+         case 'u': formatUInt(out, spec, static_cast<U>(value), 10, false, ""); return;
+         case 'o':
+            formatUInt(out, spec, static_cast<U>(value), 8, false,
+                       spec.alt && value ? "0" : "");
+            return;
+         case 'x':
+            formatUInt(out, spec, static_cast<U>(value), 16, false,
+                       spec.alt && value ? "0x" : "");
+            return;
+         case 'X':
+            formatUInt(out, spec, static_cast<U>(value), 16, true,
+                       spec.alt && value ? "0X" : "");
+            return;
+         case 'c':
+         {
+            const char c = static_cast<char>(value);
+            formatStr(out, spec, &c, 1);
+            return;
+         }
+         default:
+         {
+            const bool neg = value < static_cast<Int>(0);
+            const unsigned long long mag =
+                neg ? 0ull - static_cast<unsigned long long>(value)
+                    : static_cast<unsigned long long>(value);
+            formatUInt(out, spec, mag, 10, false,
+                       neg ? "-" : spec.plus ? "+" : spec.space ? " " : "");
+            return;
+         }
+      }
+   }
+
+   // floating point
+   template<typename T>
+   static typename std::enable_if<std::is_floating_point<T>::value>::type
+   formatArg(FormatBuffer& out, const Spec& spec, const T& arg)
+   {
+      const char conv = FormatTraits::isFloatConv(spec.conv) ? spec.conv : 'g';
+      snprintfSpec(out, spec, conv, static_cast<double>(arg));
+   }
+
+   // strings, address for %p
+   static void formatArg(FormatBuffer& out, const Spec& spec, const char* arg)
+   {
+      if(spec.conv == 'p')
+      {
+         snprintfSpec(out, spec, 'p', static_cast<const void*>(arg));
+         return;
+      }
+      if(!arg)
+      {
+         arg = "(null)";
+      }
+      std::size_t len = 0;
+      if(spec.prec >= 0)
+      {
+         const void* end = std::memchr(arg, '\0', static_cast<std::size_t>(spec.prec));
+         len = end ? static_cast<std::size_t>(static_cast<const char*>(end) - arg)
+                   : static_cast<std::size_t>(spec.prec);
+      }
+      else
+      {
+         len = std::strlen(arg);
+      }
+      formatStr(out, spec, arg, len);
+   }
+
+   static void formatArg(FormatBuffer& out, const Spec& spec, char* arg)
+   {
+      formatArg(out, spec, static_cast<const char*>(arg));
+   }
+
+   static void formatArg(FormatBuffer& out, const Spec& spec, const std::string& arg)
+   {
+      std::size_t len = arg.size();
+      if(spec.prec >= 0 && static_cast<std::size_t>(spec.prec) < len)
+      {
+         len = static_cast<std::size_t>(spec.prec);
+      }
+      formatStr(out, spec, arg.data(), len);
+   }
+
+   // other pointers
+   template<typename T>
+   static void formatArg(FormatBuffer& out, const Spec& spec, const T* arg)
+   {
+      snprintfSpec(out, spec, 'p', static_cast<const void*>(arg));
+   }
+
+   static void formatArg(FormatBuffer& out, const Spec& spec, std::nullptr_t)
+   {
+      snprintfSpec(out, spec, 'p', static_cast<const void*>(nullptr));
+   }
+
+   /**
+    * Writes digits of value with prefix (sign or 0x), precision and padding
+    */
+   static void formatUInt(FormatBuffer& out, const Spec& spec, unsigned long long value,
+                          const unsigned base, const bool upper, const char* prefix)
+   {
+      const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+      char tmp[24];
+      int n = 0;
+      if(!(value == 0 && spec.prec == 0))
+      {
+         do
+         {
+            tmp[n++] = digits[value % base];
+            value /= base;
+         } while(value);
+      }
+      const int prec     = spec.prec > n ? spec.prec : n;
+      const int pre_len  = static_cast<int>(std::strlen(prefix));
+      const int len      = pre_len + prec;
+      const int pad      = spec.width > len ? spec.width - len : 0;
+      const bool zeropad = spec.zero && !spec.left && spec.prec == NONE;
+
+      if(pad && !spec.left && !zeropad)
+      {
+         out.append(' ', static_cast<std::size_t>(pad));
+      }
+      out.append(prefix, static_cast<std::size_t>(pre_len));
+      if(pad && zeropad)
+      {
+         out.append('0', static_cast<std::size_t>(pad));
+      }
+      if(prec > n)
+      {
+         out.append('0', static_cast<std::size_t>(prec - n));
+      }
+      char* dst = out.reserve(static_cast<std::size_t>(n));
+      for(int i = 0; i < n; i++)
+      {
+         dst[i] = tmp[n - 1 - i];
+      }
+      out.commit(static_cast<std::size_t>(n));
+      if(pad && spec.left)
+      {
+         out.append(' ', static_cast<std::size_t>(pad));
+      }
+   }
+
+   /**
+    * Writes string with padding
+    */
+   static void formatStr(FormatBuffer& out, const Spec& spec, const char* str,
+                         const std::size_t len)
+   {
+      const std::size_t width = spec.width > 0 ? static_cast<std::size_t>(spec.width) : 0;
+      const std::size_t pad   = width > len ? width - len : 0;
+      if(pad && !spec.left)
+      {
+         out.append(' ', pad);
+      }
+      out.append(str, len);
+      if(pad && spec.left)
+      {
+         out.append(' ', pad);
+      }
+   }
+
+   /**
+    * Formats a single value with snprintf directly into the buffer
+    */
+   template<typename T>
+   static void snprintfSpec(FormatBuffer& out, const Spec& spec, const char conv,
+                            const T value)
+   {
+      char fmt[32];
+      char* p = fmt;
+      *p++    = '%';
+      if(spec.left) *p++ = '-';
+      if(spec.plus) *p++ = '+';
+      if(spec.space) *p++ = ' ';
+      if(spec.alt) *p++ = '#';
+      if(spec.zero) *p++ = '0';
+      if(spec.width >= 0)
+      {
+         p += std::snprintf(p, 12, "%d", spec.width);
+      }
+      if(spec.prec >= 0)
+      {
+         p += std::snprintf(p, 13, ".%d", spec.prec);
+      }
+      *p++ = conv;
+      *p   = '\0';
+
+      std::size_t avail = 64;
+      for(;;)
+      {
+         char* dst   = out.reserve(avail);
+         const int n = std::snprintf(dst, avail, fmt, value);
+         if(n < 0)
+         {
+            return;
+         }
+         if(static_cast<std::size_t>(n) < avail)
+         {
+            out.commit(static_cast<std::size_t>(n));
+            return;
+         }
+         avail = static_cast<std::size_t>(n) + 1;
+      }
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOFORMAT_H_ */
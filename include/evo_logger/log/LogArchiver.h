@@ -0,0 +1,441 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGARCHIVER_H_
+#define EVOLOGARCHIVER_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef EVO_LOGGER_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#include "evo_logger/log/RotationPolicy.h"
+
+namespace evo {
+
+/**
+ * @brief Background thread for closed log file segments
+ *
+ * Compresses closed segments to "<segment>.gz" (only if built with zlib, the CMake
+ * config defines EVO_LOGGER_HAS_ZLIB if it is found) and deletes the oldest log
+ * files of the logger (with their ".idx" index) in its folder, also from previous
+ * runs, until the retention limits of RotationPolicy are met. Files are selected
+ * by logger name, so processes logging with the same name into the same folder
+ * share the limits. Files still open by a Writer (which holds a shared flock())
+ * are never deleted, also not those of other processes. The thread runs with
+ * idle scheduling priority and is started with the first segment, pending
+ * segments are finished by the destructor.
+ *
+ * @author MSC
+ */
+class LogArchiver
+{
+ public:
+   using ErrorHandler = std::function<void(const std::string&)>; ///< error output
+
+   /**
+    * Constructor
+    *
+    * @param[in] folder  folder of log files
+    * @param[in] name    name of logger, log files are "<time>-<name>[.<n>].log[.gz]"
+    * @param[in] handler called with error messages from the background thread
+    */
+   LogArchiver(const std::string& folder, const std::string& name,
+               ErrorHandler handler = nullptr) :
+       _folder(folder.empty() ? std::string("./") : folder),
+       _name(name), _handler(handler)
+   {
+      if(_folder.back() != '/')
+      {
+         _folder += '/';
+      }
+   }
+
+   LogArchiver(const LogArchiver&) = delete;
+   LogArchiver& operator=(const LogArchiver&) = delete;
+
+   /**
+    * Destructor finishes pending segments and stops thread
+    */
+   ~LogArchiver()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop = true;
+      }
+      _cv.notify_all();
+      if(_thread.joinable())
+      {
+         _thread.join();
+      }
+   }
+
+   /**
+    * Setter for compression and retention limits
+    *
+    * @param[in] policy rotation policy
+    */
+   void setPolicy(const RotationPolicy& policy)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _policy = policy;
+   }
+
+   /**
+    * Hands a closed segment to the background thread, returns immediately
+    *
+    * @param[in] closed  path of closed segment
+    * @param[in] current path of segment in use, never deleted
+    */
+   void archive(const std::string& closed, const std::string& current)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _jobs.push_back(closed);
+         _current = current.substr(current.find_last_of('/') + 1);
+         if(!_thread.joinable())
+         {
+            _thread = std::thread(&LogArchiver::run, this);
+         }
+      }
+      _cv.notify_one();
+   }
+
+   /**
+    * Proves if closed segments are compressed
+    *
+    * @return true if built with zlib
+    */
+   static bool canCompress()
+   {
+#ifdef EVO_LOGGER_HAS_ZLIB
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   /**
+    * Compresses file to "<file>.gz" and deletes it, does nothing without zlib
+    *
+    * @param[in]  file  path of file
+    * @param[out] error reason if compression failed
+    * @return false if compression failed, file is kept
+    */
+   static bool compress(const std::string& file, std::string& error)
+   {
+#ifdef EVO_LOGGER_HAS_ZLIB
+      std::FILE* in = std::fopen(file.c_str(), "rb");
+      if(!in)
+      {
+         if(errno == ENOENT) // already deleted for retention
+         {
+            return true;
+         }
+         error = "open " + file + ": " + std::strerror(errno);
+         return false;
+      }
+      const std::string tmp = file + ".gz.tmp";
+      gzFile out            = gzopen(tmp.c_str(), "wb6");
+      if(!out)
+      {
+         std::fclose(in);
+         error = "open " + tmp + " failed";
+         return false;
+      }
+
+      std::vector<char> buf(1 << 16);
+      bool ok = true;
+      std::size_t n;
+      while(ok && (n = std::fread(buf.data(), 1, buf.size(), in)) > 0)
+      {
+         ok = gzwrite(out, buf.data(), static_cast<unsigned>(n)) ==
+              static_cast<int>(n);
+      }
+      ok = !std::ferror(in) && ok;
+      std::fclose(in);
+      ok = gzclose(out) == Z_OK && ok;
+      if(!ok || std::rename(tmp.c_str(), (file + ".gz").c_str()) != 0)
+      {
+         std::remove(tmp.c_str());
+         error = "compress " + file + " failed";
+         return false;
+      }
+      std::remove(file.c_str());
+      return true;
+#else
+      (void)file;
+      (void)error;
+      return true;
+#endif
+   }
+
+ private:
+   /**
+    * Log file of logger found in folder
+    */
+   struct LogFile
+   {
+      std::string path;      ///< full path
+      std::string stamp;     ///< time prefix of file name
+      unsigned long segment; ///< segment number, 0 for first segment
+      std::uint64_t bytes;   ///< file size
+
+      bool operator<(const LogFile& rhs) const
+      {
+         return stamp != rhs.stamp ? stamp < rhs.stamp : segment < rhs.segment;
+      }
+   };
+
+   /**
+    * Thread function, handles segments until destructor is called and no segment
+    * is left
+    */
+   void run()
+   {
+      this->lowerPriority();
+      std::unique_lock<std::mutex> lock(_mutex);
+      for(;;)
+      {
+         _cv.wait(lock, [this] { return _stop || !_jobs.empty(); });
+         if(_jobs.empty())
+         {
+            return;
+         }
+         const std::string file = _jobs.front();
+         _jobs.pop_front();
+         const RotationPolicy policy = _policy;
+         const std::string current   = _current;
+         lock.unlock();
+
+         std::string error;
+         if(policy.compress && !LogArchiver::compress(file, error))
+         {
+            this->report(error);
+         }
+         this->prune(policy, current);
+         lock.lock();
+      }
+   }
+
+   /**
+    * Deletes oldest log files of logger until retention limits are met
+    *
+    * @param[in] policy  retention limits
+    * @param[in] current file name of segment in use, never deleted
+    */
+   void prune(const RotationPolicy& policy, const std::string& current)
+   {
+      if(!policy.max_files && !policy.max_total_bytes)
+      {
+         return;
+      }
+      DIR* dir = ::opendir(_folder.c_str());
+      if(!dir)
+      {
+         this->report("open " + _folder + ": " + std::strerror(errno));
+         return;
+      }
+      std::vector<LogFile> files;
+      std::size_t count   = 1; // current segment
+      std::uint64_t total = 0;
+      while(struct dirent* entry = ::readdir(dir))
+      {
+         LogFile file;
+         if(!this->matches(entry->d_name, file))
+         {
+            continue;
+         }
+         struct stat st;
+         if(::stat(file.path.c_str(), &st) != 0)
+         {
+            continue;
+         }
+         file.bytes = static_cast<std::uint64_t>(st.st_size);
+         total += file.bytes;
+         if(entry->d_name != current)
+         {
+            files.push_back(file);
+            count++;
+         }
+      }
+      ::closedir(dir);
+
+      std::sort(files.begin(), files.end());
+      for(const LogFile& file : files)
+      {
+         if((!policy.max_files || count <= policy.max_files) &&
+            (!policy.max_total_bytes || total <= policy.max_total_bytes))
+         {
+            break;
+         }
+         const int fd = LogArchiver::lockUnused(file.path);
+         if(fd < 0) // written by another process
+         {
+            continue;
+         }
+         const bool removed = std::remove(file.path.c_str()) == 0;
+         if(!removed)
+         {
+            this->report("remove " + file.path + ": " + std::strerror(errno));
+         }
+         ::close(fd);
+         if(!removed)
+         {
+            continue;
+         }
+         std::string index = file.path; // "<segment>.log.idx", see LogIndex
+         if(LogArchiver::endsWith(index, ".gz"))
+         {
+            index.resize(index.size() - 3);
+         }
+         std::remove((index + ".idx").c_str());
+         count--;
+         total -= file.bytes;
+      }
+   }
+
+   /**
+    * Proves if name is "<time>-<name>[.<n>].log[.gz]" and fills file
+    *
+    * @param[in]  name file name
+    * @param[out] file parsed file
+    * @return true if name is a log file of logger
+    */
+   bool matches(const std::string& name, LogFile& file) const
+   {
+      // "YYYYmmdd_HH-MM-SS", see TimeFormatter
+      const std::size_t stamp_len = 17;
+      std::string rest            = name;
+      if(LogArchiver::endsWith(rest, ".gz"))
+      {
+         rest.resize(rest.size() - 3);
+      }
+      if(!LogArchiver::endsWith(rest, ".log") || rest.size() <= stamp_len + 1 ||
+         rest[stamp_len] != '-')
+      {
+         return false;
+      }
+      rest.resize(rest.size() - 4);
+      rest = rest.substr(stamp_len + 1);
+
+      file.segment = 0;
+      if(rest != _name)
+      {
+         if(rest.compare(0, _name.size() + 1, _name + ".") != 0)
+         {
+            return false;
+         }
+         const std::string number = rest.substr(_name.size() + 1);
+         if(number.empty() ||
+            number.find_first_not_of("0123456789") != std::string::npos)
+         {
+            return false;
+         }
+         file.segment = std::stoul(number);
+      }
+      file.stamp = name.substr(0, stamp_len);
+      file.path  = _folder + name;
+      return true;
+   }
+
+   /**
+    * Locks file exclusively if no Writer has it open, see Writer::openFile()
+    *
+    * @param[in] path path of file
+    * @return descriptor holding the lock, -1 if file is in use or not found
+    */
+   static int lockUnused(const std::string& path)
+   {
+      const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if(fd < 0)
+      {
+         return -1;
+      }
+      if(::flock(fd, LOCK_EX | LOCK_NB) != 0)
+      {
+         ::close(fd);
+         return -1;
+      }
+      return fd;
+   }
+
+   static bool endsWith(const std::string& str, const char* suffix)
+   {
+      const std::size_t len = std::strlen(suffix);
+      return str.size() >= len && str.compare(str.size() - len, len, suffix) == 0;
+   }
+
+   /**
+    * Sets idle scheduling (or lowest nice value) for calling thread, reports if
+    * neither is permitted
+    */
+   void lowerPriority()
+   {
+#ifdef SCHED_IDLE
+      sched_param param;
+      param.sched_priority = 0;
+      if(pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0)
+      {
+         return;
+      }
+#endif
+      const id_t tid = static_cast<id_t>(::syscall(SYS_gettid));
+      if(setpriority(PRIO_PROCESS, tid, 19) != 0)
+      {
+         this->report(std::string("lower priority: ") + std::strerror(errno));
+      }
+   }
+
+   /**
+    * Passes error message to handler
+    *
+    * @param[in] error error message
+    */
+   void report(const std::string& error)
+   {
+      if(_handler)
+      {
+         _handler(error);
+      }
+   }
+
+   std::string _folder;           ///< folder of log files, ends with '/'
+   std::string _name;             ///< name of logger
+   ErrorHandler _handler;         ///< error output
+   RotationPolicy _policy;        ///< compression and retention limits
+   std::deque<std::string> _jobs; ///< closed segments to handle
+   std::string _current;          ///< file name of segment in use
+   bool _stop = false;            ///< stops thread when no job is left
+   std::thread _thread;           ///< background thread
+   std::mutex _mutex;             ///< protects all members above
+   std::condition_variable _cv;   ///< wakes thread
+};
+
+} // namespace evo
+
+#endif /* EVOLOGARCHIVER_H_ */
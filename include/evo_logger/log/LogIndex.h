@@ -0,0 +1,363 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGINDEX_H_
+#define EVOLOGINDEX_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogType.h"
+
+namespace evo {
+
+/**
+ * @brief Index file layout, shared by LogIndex and LogReader
+ *
+ * "<file>.log.idx" starts with MAGIC, followed by one Entry per bucket of the log
+ * file in native byte order. A bucket covers consecutive logs of about
+ * LogIndex::BUCKET_BYTES bytes, logs behind the last entry (open bucket, crash)
+ * or between entries (written by someone else) are not indexed.
+ */
+namespace IndexFormat {
+
+static const char MAGIC[8] = {'E', 'V', 'O', 'L', 'I', 'D', 'X', '1'}; ///< header
+
+/**
+ * Index entry of one bucket
+ */
+struct Entry
+{
+   std::uint64_t offset;   ///< byte offset of first log of bucket in log file
+   std::uint64_t length;   ///< bytes of bucket
+   std::int64_t min_ns;    ///< smallest timestamp [ns] in bucket
+   std::int64_t max_ns;    ///< largest timestamp [ns] in bucket
+   std::uint32_t count[4]; ///< logs per level, see slot()
+};
+
+/**
+ * Slot of log level in Entry::count
+ *
+ * @param[in] level log level
+ * @return 0 INFO, 1 DEBUG, 2 WARN, 3 ERROR, -1 for other levels
+ */
+inline int slot(Log::Log level)
+{
+   switch(level)
+   {
+      case Log::INFO: return 0;
+      case Log::DEBUG: return 1;
+      case Log::WARN: return 2;
+      case Log::ERROR: return 3;
+      default: return -1;
+   }
+}
+
+} // namespace IndexFormat
+
+/**
+ * @brief Writes the sparse index of a log file, used by Writer and MmapWriter
+ *
+ * Every written log is passed to add() with its byte offset. Logs are grouped into
+ * buckets of about BUCKET_BYTES bytes, a closed bucket is kept as one
+ * IndexFormat::Entry (48 bytes, < 0.1 % of the log file) until flush() appends it
+ * to the index file. The index file is created on first flush of an entry.
+ *
+ * @author MSC
+ */
+class LogIndex
+{
+ public:
+   static const std::size_t BUCKET_BYTES = 64 << 10; ///< bytes per bucket
+
+   /**
+    * Constructor
+    *
+    * @param[in] file path of index file, usually "<log file>.idx"
+    */
+   explicit LogIndex(const std::string& file) : _file(file) { this->reset(); }
+
+   LogIndex(const LogIndex&) = delete;
+   LogIndex& operator=(const LogIndex&) = delete;
+
+   /**
+    * Destructor writes open bucket
+    */
+   ~LogIndex()
+   {
+      this->finish();
+      this->closeFile();
+   }
+
+   /**
+    * Adds written log, closes bucket when it is full
+    *
+    * @param[in] ns     timestamp of log [ns] since epoch as written into the log
+    *                   file, see TimeFormatter::truncate()
+    * @param[in] level  log level of log
+    * @param[in] offset byte offset of log in log file
+    * @param[in] len    bytes of formatted log including line break
+    */
+   void add(const std::int64_t ns, Log::Log level, const std::uint64_t offset,
+            const std::size_t len)
+   {
+      if(_open.length && offset != _open.offset + _open.length)
+      {
+         this->close(); // gap, e.g. file was appended by someone else
+      }
+      if(!_open.length)
+      {
+         _open.offset = offset;
+         _open.min_ns = ns;
+         _open.max_ns = ns;
+      }
+      _open.length += len;
+      _open.min_ns = ns < _open.min_ns ? ns : _open.min_ns;
+      _open.max_ns = ns > _open.max_ns ? ns : _open.max_ns;
+      const int slot = IndexFormat::slot(level);
+      if(slot >= 0)
+      {
+         _open.count[slot]++;
+      }
+      if(_open.length >= BUCKET_BYTES)
+      {
+         this->close();
+      }
+   }
+
+   /**
+    * Appends closed buckets to index file, call after the logs are written
+    *
+    * If a write fails, the unwritten entries are kept for the next flush(). A
+    * partially written entry is cut off again (now or before the next append),
+    * so the file keeps whole entries only.
+    *
+    * @return false if index file could not be written, see lastError()
+    */
+   bool flush()
+   {
+      if(_closed.empty())
+      {
+         return true;
+      }
+      if(_fd < 0 && !this->open())
+      {
+         return false;
+      }
+      const off_t end = this->wholeEntries();
+      if(end < 0)
+      {
+         return false;
+      }
+      const std::size_t size = _closed.size() * sizeof(IndexFormat::Entry);
+      const char* data       = reinterpret_cast<const char*>(_closed.data());
+      std::size_t done       = 0;
+      while(done < size)
+      {
+         const ssize_t n = ::write(_fd, data + done, size - done);
+         if(n < 0)
+         {
+            if(errno == EINTR)
+            {
+               continue;
+            }
+            _error = "write " + _file + ": " + std::strerror(errno);
+            const std::size_t whole = done / sizeof(IndexFormat::Entry);
+            if(::ftruncate(_fd, end + static_cast<off_t>(
+                                    whole * sizeof(IndexFormat::Entry))) != 0)
+            {
+               // partial entry is cut off by wholeEntries() of next flush
+               _error += ", truncate: " + std::string(std::strerror(errno));
+            }
+            _closed.erase(_closed.begin(),
+                          _closed.begin() + static_cast<std::ptrdiff_t>(whole));
+            return false;
+         }
+         done += static_cast<std::size_t>(n);
+      }
+      _closed.clear();
+      return true;
+   }
+
+   /**
+    * Closes open bucket and appends it, call when the log file is closed
+    *
+    * @return false if index file could not be written, see lastError()
+    */
+   bool finish()
+   {
+      this->close();
+      return this->flush();
+   }
+
+   /**
+    * Drops buckets not written completely to the log file, call before finish()
+    * if the tail of the log file could not be written
+    *
+    * @param[in] length bytes written to log file
+    */
+   void truncate(const std::uint64_t length)
+   {
+      this->close();
+      while(!_closed.empty() &&
+            _closed.back().offset + _closed.back().length > length)
+      {
+         _closed.pop_back();
+      }
+   }
+
+   /**
+    * Reads index file
+    *
+    * @param[in]  file    path of index file
+    * @param[out] entries entries of file
+    * @return false if file is missing or no index file
+    */
+   static bool load(const std::string& file,
+                    std::vector<IndexFormat::Entry>& entries)
+   {
+      entries.clear();
+      const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+      if(fd < 0)
+      {
+         return false;
+      }
+      const ssize_t head = static_cast<ssize_t>(sizeof(IndexFormat::MAGIC));
+      struct stat st;
+      char magic[sizeof(IndexFormat::MAGIC)];
+      bool ok = ::fstat(fd, &st) == 0 && ::read(fd, magic, head) == head &&
+                std::memcmp(magic, IndexFormat::MAGIC, sizeof(magic)) == 0;
+      if(ok)
+      {
+         const std::size_t bytes = static_cast<std::size_t>(st.st_size - head);
+         entries.resize(bytes / sizeof(IndexFormat::Entry)); // partial entry ignored
+         char* data             = reinterpret_cast<char*>(entries.data());
+         const std::size_t want = entries.size() * sizeof(IndexFormat::Entry);
+         std::size_t done       = 0;
+         while(ok && done < want)
+         {
+            const ssize_t n = ::read(fd, data + done, want - done);
+            ok = n > 0;
+            done += ok ? static_cast<std::size_t>(n) : 0;
+         }
+      }
+      ::close(fd);
+      if(!ok)
+      {
+         entries.clear();
+      }
+      return ok;
+   }
+
+   /**
+    * Getter for reason of last failed write
+    *
+    * @return error message, empty if no error occured
+    */
+   const std::string& lastError() const { return _error; }
+
+ private:
+   /**
+    * Moves open bucket to closed ones
+    */
+   void close()
+   {
+      if(!_open.length)
+      {
+         return;
+      }
+      _closed.push_back(_open);
+      this->reset();
+   }
+
+   void reset()
+   {
+      std::memset(&_open, 0, sizeof(_open));
+   }
+
+   /**
+    * Opens index file for appending, writes header to new file
+    *
+    * @return true if open, on error the file is closed again (and a partially
+    * written header removed), so the next flush() retries
+    */
+   bool open()
+   {
+      _fd = ::open(_file.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+      struct stat st;
+      if(_fd < 0 || ::fstat(_fd, &st) != 0)
+      {
+         _error = "open " + _file + ": " + std::strerror(errno);
+         this->closeFile();
+         return false;
+      }
+      if(st.st_size == 0 &&
+         ::write(_fd, IndexFormat::MAGIC, sizeof(IndexFormat::MAGIC)) !=
+             static_cast<ssize_t>(sizeof(IndexFormat::MAGIC)))
+      {
+         _error = "write " + _file + ": " + std::strerror(errno);
+         if(::ftruncate(_fd, 0) != 0)
+         {
+            // header is checked by load(), a broken file is ignored there
+            _error += ", truncate: " + std::string(std::strerror(errno));
+         }
+         this->closeFile();
+         return false;
+      }
+      _error.clear();
+      return true;
+   }
+
+   /**
+    * Cuts off a partially written entry at the end of the index file
+    *
+    * @return length of index file, -1 on error
+    */
+   off_t wholeEntries()
+   {
+      struct stat st;
+      if(::fstat(_fd, &st) != 0)
+      {
+         _error = "stat " + _file + ": " + std::strerror(errno);
+         return -1;
+      }
+      const off_t head  = static_cast<off_t>(sizeof(IndexFormat::MAGIC));
+      const off_t entry = static_cast<off_t>(sizeof(IndexFormat::Entry));
+      const off_t end =
+          st.st_size < head ? st.st_size : st.st_size - (st.st_size - head) % entry;
+      if(end != st.st_size && ::ftruncate(_fd, end) != 0)
+      {
+         _error = "truncate " + _file + ": " + std::strerror(errno);
+         return -1;
+      }
+      return end;
+   }
+
+   void closeFile()
+   {
+      if(_fd >= 0)
+      {
+         ::close(_fd);
+         _fd = -1;
+      }
+   }
+
+   std::string _file;                       ///< path of index file
+   int _fd = -1;                            ///< descriptor of index file
+   IndexFormat::Entry _open;                ///< bucket being filled
+   std::vector<IndexFormat::Entry> _closed; ///< closed buckets not written yet
+   std::string _error;                      ///< last error
+};
+
+} // namespace evo
+
+#endif /* EVOLOGINDEX_H_ */
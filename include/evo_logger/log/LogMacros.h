@@ -0,0 +1,281 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGMACROS_H_
+#define EVOLOGMACROS_H_
+
+/**
+ * @file LogMacros.h
+ * @brief Level macros with lazy argument evaluation and compile time removal
+ *
+ * EVO_DEBUG/EVO_INFO/EVO_WARN/EVO_ERROR take a format string literal and
+ * printf-style arguments, which are checked against the format at compile time
+ * (see FormatCheck). The *_STREAM variants take a stream expression. Arguments are
+ * only evaluated and formatted if the level is enabled at runtime
+ * (Logger::isEnabled()).
+ *
+ * Every macro keeps a static Callsite (file, line, function, level, format) which
+ * is passed with the log, so single call sites or files can be switched on or off
+ * at runtime and the location can be printed (see Callsite).
+ *
+ * Levels below EVO_LOG_MIN_LEVEL are removed at compile time, the arguments are
+ * still type checked but never evaluated. Set it with the CMake cache variable
+ * EVO_LOG_MIN_LEVEL (DEBUG, INFO, WARN, ERROR), default is INFO for Release and
+ * MinSizeRel builds and DEBUG otherwise.
+ *
+ * @code
+ * EVO_DEBUG("range %f", computeRange()); // computeRange() only called if enabled
+ * EVO_INFO("%s", some_std_string);
+ * EVO_INFO_STREAM("pose " << pose);
+ * @endcode
+ *
+ * Rate limited variants keep their state per call site in static storage (see
+ * RateLimit), suppressed calls are counted and summarized periodically:
+ * @code
+ * EVO_WARN_EVERY_N(100, "timeout %d", id); // 1st, 101st, 201st, ... call
+ * EVO_WARN_FIRST_N(5, "timeout %d", id);   // first 5 calls only
+ * EVO_WARN_THROTTLE(2, "timeout %d", id);  // at most 2 calls per second
+ * @endcode
+ *
+ * Structured variants take a message and typed key/value pairs (see Field), the
+ * values are only evaluated if the level is enabled:
+ * @code
+ * EVO_INFO_FIELDS("connected", {"host", host}, {"port", port});
+ * @endcode
+ *
+ * Channel variants take a Channel handle first, its level mask is checked before
+ * the levels of the Logger (see Channel):
+ * @code
+ * evo::Channel& lidar = evo::log::channel("driver.lidar");
+ * EVO_CH_DEBUG(lidar, "scan %d", n);
+ * EVO_CH_WARN_STREAM(lidar, "pose " << pose);
+ * @endcode
+ */
+
+#define EVO_LOG_LEVEL_DEBUG 0 ///< severity of DEBUG for EVO_LOG_MIN_LEVEL
+#define EVO_LOG_LEVEL_INFO 1  ///< severity of INFO for EVO_LOG_MIN_LEVEL
+#define EVO_LOG_LEVEL_WARN 2  ///< severity of WARN for EVO_LOG_MIN_LEVEL
+#define EVO_LOG_LEVEL_ERROR 3 ///< severity of ERROR for EVO_LOG_MIN_LEVEL
+
+#ifndef EVO_LOG_MIN_LEVEL
+#define EVO_LOG_MIN_LEVEL EVO_LOG_LEVEL_DEBUG
+#endif
+
+#define EVO_LOG_SITE_(level, format)                                               \
+   static evo::Callsite evo_site_(level, __FILE__, __LINE__, __func__, format)
+
+#define EVO_LOG_IF_(level, ...)                                                    \
+   do                                                                              \
+   {                                                                               \
+      EVO_FORMAT_CHECK(__VA_ARGS__);                                               \
+      EVO_LOG_SITE_(level, EVO_FORMAT_FIRST_(__VA_ARGS__));                        \
+      if(evo::log::get().isEnabled(evo_site_))                                     \
+      {                                                                            \
+         evo::log::at(evo_site_, __VA_ARGS__);                                     \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_STREAM_IF_(level, args)                                            \
+   do                                                                              \
+   {                                                                               \
+      EVO_LOG_SITE_(level, #args);                                                 \
+      if(evo::log::get().isEnabled(evo_site_))                                     \
+      {                                                                            \
+         evo::LogStream& evo_stream_ = evo::log::get().stream();                   \
+         evo_stream_ << args;                                                      \
+         evo::log::get().log(level, evo_stream_.data(), evo_stream_.size(),        \
+                             &evo_site_);                                          \
+         evo_stream_.reset();                                                      \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_LIMITED_IF_(level, kind, n, ...)                                   \
+   do                                                                              \
+   {                                                                               \
+      EVO_FORMAT_CHECK(__VA_ARGS__);                                               \
+      EVO_LOG_SITE_(level, EVO_FORMAT_FIRST_(__VA_ARGS__));                        \
+      static evo::RateLimit evo_rate_limit_(evo::RateLimit::kind, n, __FILE__,     \
+                                            __LINE__);                             \
+      if(evo::log::get().isEnabled(evo_site_) && evo_rate_limit_.pass())           \
+      {                                                                            \
+         evo::log::at(evo_site_, __VA_ARGS__);                                     \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_FIELDS_IF_(level, msg, ...)                                        \
+   do                                                                              \
+   {                                                                               \
+      EVO_LOG_SITE_(level, msg);                                                   \
+      if(evo::log::get().isEnabled(evo_site_))                                     \
+      {                                                                            \
+         evo::log::get().log(level, msg, {__VA_ARGS__}, &evo_site_);               \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_CH_IF_(channel, level, ...)                                        \
+   do                                                                              \
+   {                                                                               \
+      EVO_FORMAT_CHECK(__VA_ARGS__);                                               \
+      EVO_LOG_SITE_(level, EVO_FORMAT_FIRST_(__VA_ARGS__));                        \
+      if(evo::log::get().isEnabled(channel, evo_site_))                            \
+      {                                                                            \
+         evo::log::at(channel, evo_site_, __VA_ARGS__);                            \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_CH_STREAM_IF_(channel, level, args)                                \
+   do                                                                              \
+   {                                                                               \
+      EVO_LOG_SITE_(level, #args);                                                 \
+      if(evo::log::get().isEnabled(channel, evo_site_))                            \
+      {                                                                            \
+         evo::LogStream& evo_stream_ = evo::log::get().stream();                   \
+         evo_stream_ << args;                                                      \
+         evo::log::get().log(channel, level, evo_stream_.data(),                   \
+                             evo_stream_.size(), &evo_site_);                      \
+         evo_stream_.reset();                                                      \
+      }                                                                            \
+   } while(0)
+
+// removed call sites stay type checked, but are never executed
+#define EVO_LOG_REMOVED_(func, ...)                                                \
+   do                                                                              \
+   {                                                                               \
+      EVO_FORMAT_CHECK(__VA_ARGS__);                                               \
+      if(false)                                                                    \
+      {                                                                            \
+         evo::log::func(__VA_ARGS__);                                              \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_FIELDS_REMOVED_(msg, ...)                                          \
+   do                                                                              \
+   {                                                                               \
+      if(false)                                                                    \
+      {                                                                            \
+         evo::log::get().log(evo::Log::INFO, msg, {__VA_ARGS__});                  \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_CH_REMOVED_(channel, ...)                                          \
+   do                                                                              \
+   {                                                                               \
+      EVO_FORMAT_CHECK(__VA_ARGS__);                                               \
+      if(false)                                                                    \
+      {                                                                            \
+         evo::log::get().log(channel, evo::Log::INFO, "", 0);                      \
+      }                                                                            \
+   } while(0)
+
+#define EVO_LOG_STREAM_REMOVED_(args)                                              \
+   do                                                                              \
+   {                                                                               \
+      if(false)                                                                    \
+      {                                                                            \
+         evo::log::get() << args;                                                  \
+      }                                                                            \
+   } while(0)
+
+#if EVO_LOG_MIN_LEVEL <= EVO_LOG_LEVEL_DEBUG
+#define EVO_DEBUG(...) EVO_LOG_IF_(evo::Log::DEBUG, __VA_ARGS__)
+#define EVO_DEBUG_STREAM(args) EVO_LOG_STREAM_IF_(evo::Log::DEBUG, args)
+#define EVO_CH_DEBUG(ch, ...) EVO_LOG_CH_IF_(ch, evo::Log::DEBUG, __VA_ARGS__)
+#define EVO_CH_DEBUG_STREAM(ch, args)                                              \
+   EVO_LOG_CH_STREAM_IF_(ch, evo::Log::DEBUG, args)
+#define EVO_DEBUG_FIELDS(msg, ...)                                                 \
+   EVO_LOG_FIELDS_IF_(evo::Log::DEBUG, msg, __VA_ARGS__)
+#define EVO_DEBUG_EVERY_N(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::DEBUG, EVERY_N, n, __VA_ARGS__)
+#define EVO_DEBUG_FIRST_N(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::DEBUG, FIRST_N, n, __VA_ARGS__)
+#define EVO_DEBUG_THROTTLE(n, ...)                                                 \
+   EVO_LOG_LIMITED_IF_(evo::Log::DEBUG, PER_SECOND, n, __VA_ARGS__)
+#else
+#define EVO_DEBUG(...) EVO_LOG_REMOVED_(debug, __VA_ARGS__)
+#define EVO_DEBUG_STREAM(args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_CH_DEBUG(ch, ...) EVO_LOG_CH_REMOVED_(ch, __VA_ARGS__)
+#define EVO_CH_DEBUG_STREAM(ch, args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_DEBUG_FIELDS(msg, ...) EVO_LOG_FIELDS_REMOVED_(msg, __VA_ARGS__)
+#define EVO_DEBUG_EVERY_N(n, ...) EVO_LOG_REMOVED_(debug, __VA_ARGS__)
+#define EVO_DEBUG_FIRST_N(n, ...) EVO_LOG_REMOVED_(debug, __VA_ARGS__)
+#define EVO_DEBUG_THROTTLE(n, ...) EVO_LOG_REMOVED_(debug, __VA_ARGS__)
+#endif
+
+#if EVO_LOG_MIN_LEVEL <= EVO_LOG_LEVEL_INFO
+#define EVO_INFO(...) EVO_LOG_IF_(evo::Log::INFO, __VA_ARGS__)
+#define EVO_INFO_STREAM(args) EVO_LOG_STREAM_IF_(evo::Log::INFO, args)
+#define EVO_CH_INFO(ch, ...) EVO_LOG_CH_IF_(ch, evo::Log::INFO, __VA_ARGS__)
+#define EVO_CH_INFO_STREAM(ch, args)                                               \
+   EVO_LOG_CH_STREAM_IF_(ch, evo::Log::INFO, args)
+#define EVO_INFO_FIELDS(msg, ...)                                                  \
+   EVO_LOG_FIELDS_IF_(evo::Log::INFO, msg, __VA_ARGS__)
+#define EVO_INFO_EVERY_N(n, ...)                                                   \
+   EVO_LOG_LIMITED_IF_(evo::Log::INFO, EVERY_N, n, __VA_ARGS__)
+#define EVO_INFO_FIRST_N(n, ...)                                                   \
+   EVO_LOG_LIMITED_IF_(evo::Log::INFO, FIRST_N, n, __VA_ARGS__)
+#define EVO_INFO_THROTTLE(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::INFO, PER_SECOND, n, __VA_ARGS__)
+#else
+#define EVO_INFO(...) EVO_LOG_REMOVED_(info, __VA_ARGS__)
+#define EVO_INFO_STREAM(args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_CH_INFO(ch, ...) EVO_LOG_CH_REMOVED_(ch, __VA_ARGS__)
+#define EVO_CH_INFO_STREAM(ch, args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_INFO_FIELDS(msg, ...) EVO_LOG_FIELDS_REMOVED_(msg, __VA_ARGS__)
+#define EVO_INFO_EVERY_N(n, ...) EVO_LOG_REMOVED_(info, __VA_ARGS__)
+#define EVO_INFO_FIRST_N(n, ...) EVO_LOG_REMOVED_(info, __VA_ARGS__)
+#define EVO_INFO_THROTTLE(n, ...) EVO_LOG_REMOVED_(info, __VA_ARGS__)
+#endif
+
+#if EVO_LOG_MIN_LEVEL <= EVO_LOG_LEVEL_WARN
+#define EVO_WARN(...) EVO_LOG_IF_(evo::Log::WARN, __VA_ARGS__)
+#define EVO_WARN_STREAM(args) EVO_LOG_STREAM_IF_(evo::Log::WARN, args)
+#define EVO_CH_WARN(ch, ...) EVO_LOG_CH_IF_(ch, evo::Log::WARN, __VA_ARGS__)
+#define EVO_CH_WARN_STREAM(ch, args)                                               \
+   EVO_LOG_CH_STREAM_IF_(ch, evo::Log::WARN, args)
+#define EVO_WARN_FIELDS(msg, ...)                                                  \
+   EVO_LOG_FIELDS_IF_(evo::Log::WARN, msg, __VA_ARGS__)
+#define EVO_WARN_EVERY_N(n, ...)                                                   \
+   EVO_LOG_LIMITED_IF_(evo::Log::WARN, EVERY_N, n, __VA_ARGS__)
+#define EVO_WARN_FIRST_N(n, ...)                                                   \
+   EVO_LOG_LIMITED_IF_(evo::Log::WARN, FIRST_N, n, __VA_ARGS__)
+#define EVO_WARN_THROTTLE(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::WARN, PER_SECOND, n, __VA_ARGS__)
+#else
+#define EVO_WARN(...) EVO_LOG_REMOVED_(warn, __VA_ARGS__)
+#define EVO_WARN_STREAM(args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_CH_WARN(ch, ...) EVO_LOG_CH_REMOVED_(ch, __VA_ARGS__)
+#define EVO_CH_WARN_STREAM(ch, args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_WARN_FIELDS(msg, ...) EVO_LOG_FIELDS_REMOVED_(msg, __VA_ARGS__)
+#define EVO_WARN_EVERY_N(n, ...) EVO_LOG_REMOVED_(warn, __VA_ARGS__)
+#define EVO_WARN_FIRST_N(n, ...) EVO_LOG_REMOVED_(warn, __VA_ARGS__)
+#define EVO_WARN_THROTTLE(n, ...) EVO_LOG_REMOVED_(warn, __VA_ARGS__)
+#endif
+
+#if EVO_LOG_MIN_LEVEL <= EVO_LOG_LEVEL_ERROR
+#define EVO_ERROR(...) EVO_LOG_IF_(evo::Log::ERROR, __VA_ARGS__)
+#define EVO_ERROR_STREAM(args) EVO_LOG_STREAM_IF_(evo::Log::ERROR, args)
+#define EVO_CH_ERROR(ch, ...) EVO_LOG_CH_IF_(ch, evo::Log::ERROR, __VA_ARGS__)
+#define EVO_CH_ERROR_STREAM(ch, args)                                              \
+   EVO_LOG_CH_STREAM_IF_(ch, evo::Log::ERROR, args)
+#define EVO_ERROR_FIELDS(msg, ...)                                                 \
+   EVO_LOG_FIELDS_IF_(evo::Log::ERROR, msg, __VA_ARGS__)
+#define EVO_ERROR_EVERY_N(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::ERROR, EVERY_N, n, __VA_ARGS__)
+#define EVO_ERROR_FIRST_N(n, ...)                                                  \
+   EVO_LOG_LIMITED_IF_(evo::Log::ERROR, FIRST_N, n, __VA_ARGS__)
+#define EVO_ERROR_THROTTLE(n, ...)                                                 \
+   EVO_LOG_LIMITED_IF_(evo::Log::ERROR, PER_SECOND, n, __VA_ARGS__)
+#else
+#define EVO_ERROR(...) EVO_LOG_REMOVED_(error, __VA_ARGS__)
+#define EVO_ERROR_STREAM(args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_CH_ERROR(ch, ...) EVO_LOG_CH_REMOVED_(ch, __VA_ARGS__)
+#define EVO_CH_ERROR_STREAM(ch, args) EVO_LOG_STREAM_REMOVED_(args)
+#define EVO_ERROR_FIELDS(msg, ...) EVO_LOG_FIELDS_REMOVED_(msg, __VA_ARGS__)
+#define EVO_ERROR_EVERY_N(n, ...) EVO_LOG_REMOVED_(error, __VA_ARGS__)
+#define EVO_ERROR_FIRST_N(n, ...) EVO_LOG_REMOVED_(error, __VA_ARGS__)
+#define EVO_ERROR_THROTTLE(n, ...) EVO_LOG_REMOVED_(error, __VA_ARGS__)
+#endif
+
+#endif /* EVOLOGMACROS_H_ */
@@ -0,0 +1,404 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGREADER_H_
+#define EVOLOGREADER_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogIndex.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/time/TimeFormatter.h"
+
+namespace evo {
+
+/**
+ * @brief Offline reader of .log files, queries logs by time range and level
+ *
+ * The log file is mapped read-only. If the index "<file>.idx" written by Writer
+ * exists (see LogIndex), only buckets which may contain logs of the query are
+ * parsed, the rest of the file is skipped without being read. Logs not covered by
+ * the index (open bucket of a crashed process, files written by FileSink) are
+ * parsed completely, so a query returns the same logs with and without index.
+ *
+ * A log starts with a line "[<time>]-[<LEVEL>]", following lines without such a
+ * header belong to it (messages with line breaks).
+ *
+ * @code
+ * evo::LogReader reader("20190304_12-00-00-name.log");
+ * reader.query(from_ns, to_ns, evo::Log::WARN | evo::Log::ERROR,
+ *              [](const evo::LogReader::Line& line) {
+ *                 std::cout.write(line.data, line.size) << '\n';
+ *              });
+ * @endcode
+ *
+ * @author MSC
+ */
+class LogReader
+{
+ public:
+   /**
+    * One log of the file
+    */
+   struct Line
+   {
+      std::int64_t ns;  ///< timestamp [ns] since epoch
+      Log::Log level;   ///< log level
+      const char* data; ///< formatted log as written, valid while reader exists
+      std::size_t size; ///< length without final line break
+   };
+
+   using Handler = std::function<void(const Line&)>; ///< called for matching logs
+
+   /**
+    * Constructor maps file and loads its index
+    *
+    * @param[in] file path of log file
+    */
+   explicit LogReader(const std::string& file) : _file(file)
+   {
+      const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat st;
+      if(fd < 0 || ::fstat(fd, &st) != 0)
+      {
+         this->setError("open");
+         if(fd >= 0)
+         {
+            ::close(fd);
+         }
+         return;
+      }
+      _map_size = static_cast<std::size_t>(st.st_size);
+      if(_map_size)
+      {
+         void* map = ::mmap(nullptr, _map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if(map == MAP_FAILED)
+         {
+            this->setError("mmap");
+            _map_size = 0;
+         }
+         else
+         {
+            _data = static_cast<const char*>(map);
+            ::madvise(map, _map_size, MADV_SEQUENTIAL);
+         }
+      }
+      ::close(fd);
+      _open = _error.empty();
+
+      // zero filled tail of MmapWriter after crash
+      _size = _map_size;
+      while(_size && _data[_size - 1] == '\0')
+      {
+         _size--;
+      }
+      LogIndex::load(file + ".idx", _index);
+   }
+
+   LogReader(const LogReader&) = delete;
+   LogReader& operator=(const LogReader&) = delete;
+
+   /**
+    * Destructor unmaps file
+    */
+   ~LogReader()
+   {
+      if(_data)
+      {
+         ::munmap(const_cast<char*>(_data), _map_size);
+      }
+   }
+
+   /**
+    * Calls func for every log with ns in [from, to] and level in levels, in the
+    * order of the file
+    *
+    * Index entries are checked one after the other instead of a binary search,
+    * timestamps are not monotonic in the file: they are taken before the Logger is
+    * locked, threads and the async queue interleave, the system clock may step.
+    * The check costs one 48 byte entry per 64 KiB bucket, reading logs dominates.
+    *
+    * @param[in] from   first timestamp [ns], INT64_MIN for no limit
+    * @param[in] to     last timestamp [ns], INT64_MAX for no limit
+    * @param[in] levels level mask, e.g. Log::WARN | Log::ERROR
+    * @param[in] func   called with matching logs
+    * @return number of matching logs
+    */
+   std::size_t query(const std::int64_t from, const std::int64_t to,
+                     const LogType levels, const Handler& func)
+   {
+      _scanned        = 0;
+      Query q         = {from, to, levels, &func, 0};
+      std::size_t pos = 0;
+      for(const IndexFormat::Entry& e : this->entries())
+      {
+         if(e.offset < pos || e.offset + e.length > _size)
+         {
+            break; // index does not fit file, parse rest
+         }
+         this->scan(q, pos, static_cast<std::size_t>(e.offset)); // not indexed gap
+         pos = static_cast<std::size_t>(e.offset + e.length);
+         if(e.max_ns >= from && e.min_ns <= to && LogReader::hasLevel(e, levels))
+         {
+            this->scan(q, static_cast<std::size_t>(e.offset), pos);
+         }
+      }
+      this->scan(q, pos, _size);
+      return q.matches;
+   }
+
+   /**
+    * Writes a new index for the file, e.g. for files of older versions or after a
+    * crash, previous index is replaced
+    *
+    * @return false if index file could not be written, see lastError()
+    */
+   bool buildIndex()
+   {
+      const std::string path = _file + ".idx";
+      std::remove(path.c_str());
+      bool ok = true;
+      {
+         LogIndex index(path);
+         std::size_t start = 0;
+         Line log          = Line();
+         bool valid        = false;
+         for(std::size_t pos = 0; pos < _size;)
+         {
+            const std::size_t end = this->lineEnd(pos);
+            Line next;
+            if(this->header(pos, end, next))
+            {
+               if(valid)
+               {
+                  index.add(log.ns, log.level, start, pos - start);
+               }
+               log   = next;
+               start = pos;
+               valid = true;
+            }
+            pos = end < _size ? end + 1 : _size;
+         }
+         if(valid)
+         {
+            index.add(log.ns, log.level, start, _size - start);
+         }
+         ok = index.finish();
+         if(!ok)
+         {
+            _error = index.lastError();
+         }
+      }
+      LogIndex::load(path, _index);
+      return ok;
+   }
+
+   /**
+    * Disables or enables use of the index, e.g. to compare with a full scan
+    *
+    * @param[in] enable true to skip buckets with the index
+    */
+   void setUseIndex(const bool enable) { _use_index = enable; }
+
+   /**
+    * Proves if file could be mapped
+    *
+    * @return true if open
+    */
+   bool isOpen() const { return _open; }
+
+   /**
+    * Proves if an index was loaded for the file
+    *
+    * @return true if index exists
+    */
+   bool hasIndex() const { return !_index.empty(); }
+
+   /**
+    * Getter for size of log file
+    *
+    * @return bytes without zero filled tail
+    */
+   std::size_t size() const { return _size; }
+
+   /**
+    * Getter for bytes parsed by last query()
+    *
+    * @return bytes
+    */
+   std::size_t scanned() const { return _scanned; }
+
+   /**
+    * Getter for reason of failed open or index write
+    *
+    * @return error message, empty if no error occured
+    */
+   const std::string& lastError() const { return _error; }
+
+   /**
+    * Parses log level as printed in log files ("INFO ", "DEBUG", ...)
+    *
+    * @param[in]  str   pointer to level, at least 5 chars
+    * @param[out] level parsed level
+    * @return false if str is no level
+    */
+   static bool parseLevel(const char* str, Log::Log& level)
+   {
+      static const Log::Log levels[] = {Log::INFO, Log::DEBUG, Log::WARN,
+                                        Log::ERROR};
+      for(const Log::Log l : levels)
+      {
+         if(std::memcmp(str, LEVEL_STR[static_cast<LogType>(l)].data(), 5) == 0)
+         {
+            level = l;
+            return true;
+         }
+      }
+      return false;
+   }
+
+ private:
+   /**
+    * State of running query
+    */
+   struct Query
+   {
+      std::int64_t from;   ///< first timestamp
+      std::int64_t to;     ///< last timestamp
+      LogType levels;      ///< level mask
+      const Handler* func; ///< called with matches
+      std::size_t matches; ///< number of matches
+   };
+
+   static bool hasLevel(const IndexFormat::Entry& e, const LogType levels)
+   {
+      return ((levels & Log::INFO) && e.count[0]) ||
+             ((levels & Log::DEBUG) && e.count[1]) ||
+             ((levels & Log::WARN) && e.count[2]) ||
+             ((levels & Log::ERROR) && e.count[3]);
+   }
+
+   const std::vector<IndexFormat::Entry>& entries() const
+   {
+      static const std::vector<IndexFormat::Entry> none;
+      return _use_index ? _index : none;
+   }
+
+   /**
+    * Parses logs in [begin, end) and passes matches to the handler, begin is the
+    * start of a log
+    */
+   void scan(Query& q, const std::size_t begin, const std::size_t end)
+   {
+      if(begin >= end)
+      {
+         return;
+      }
+      _scanned += end - begin;
+      Line log   = Line();
+      bool match = false;
+      for(std::size_t pos = begin; pos < end;)
+      {
+         std::size_t stop = this->lineEnd(pos);
+         stop             = stop < end ? stop : end;
+         Line next;
+         if(this->header(pos, stop, next))
+         {
+            if(match)
+            {
+               this->emit(q, log, pos);
+            }
+            log   = next;
+            match = next.ns >= q.from && next.ns <= q.to &&
+                    (static_cast<LogType>(next.level) & q.levels);
+         }
+         pos = stop + 1;
+      }
+      if(match)
+      {
+         this->emit(q, log, end);
+      }
+   }
+
+   /**
+    * Passes log ending before next to the handler
+    */
+   void emit(Query& q, Line& log, const std::size_t next)
+   {
+      log.size = static_cast<std::size_t>(_data + next - log.data);
+      if(log.size && log.data[log.size - 1] == '\n')
+      {
+         log.size--;
+      }
+      (*q.func)(log);
+      q.matches++;
+   }
+
+   /**
+    * Finds line break of line starting at pos
+    *
+    * @return position of line break, _size if last line has none
+    */
+   std::size_t lineEnd(const std::size_t pos) const
+   {
+      const void* nl = std::memchr(_data + pos, '\n', _size - pos);
+      return nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - _data)
+                : _size;
+   }
+
+   /**
+    * Parses "[<time>]-[<LEVEL>]" at start of line [pos, end)
+    *
+    * @return false if line is no start of a log
+    */
+   bool header(const std::size_t pos, const std::size_t end, Line& log) const
+   {
+      const char* str       = _data + pos;
+      const std::size_t len = end - pos;
+      if(!len || str[0] != '[')
+      {
+         return false;
+      }
+      const std::size_t n = TimeFormatter::parse(str + 1, len - 1, log.ns);
+      if(!n || len < n + 10 || std::memcmp(str + 1 + n, "]-[", 3) != 0 ||
+         str[n + 9] != ']' || !LogReader::parseLevel(str + n + 4, log.level))
+      {
+         return false;
+      }
+      log.data = str;
+      log.size = 0;
+      return true;
+   }
+
+   void setError(const char* op)
+   {
+      _error = std::string(op) + " " + _file + ": " + std::strerror(errno);
+   }
+
+   std::string _file;                      ///< path of log file
+   const char* _data     = nullptr;        ///< mapped file
+   std::size_t _map_size = 0;              ///< size of mapping
+   std::size_t _size     = 0;              ///< size without zero filled tail
+   bool _open            = false;          ///< file is mapped
+   bool _use_index       = true;           ///< skip buckets with index
+   std::vector<IndexFormat::Entry> _index; ///< entries of index file
+   std::size_t _scanned = 0;               ///< bytes parsed by last query
+   std::string _error;                     ///< last error
+};
+
+} // namespace evo
+
+#endif /* EVOLOGREADER_H_ */
@@ -0,0 +1,333 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGSTATS_H_
+#define EVOLOGSTATS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "evo_logger/base/ThreadRegistry.h"
+#include "evo_logger/time/Histogram.h"
+
+namespace evo {
+
+/**
+ * Counter written by one thread and read by others (relaxed load and store, no
+ * locked instruction)
+ */
+class SharedCounter
+{
+ public:
+   void add(const std::uint64_t n)
+   {
+      _value.store(_value.load(std::memory_order_relaxed) + n,
+                   std::memory_order_relaxed);
+   }
+
+   /**
+    * Raises value to n if it is smaller
+    */
+   void raise(const std::uint64_t n)
+   {
+      if(n > _value.load(std::memory_order_relaxed))
+      {
+         _value.store(n, std::memory_order_relaxed);
+      }
+   }
+
+   std::uint64_t get() const { return _value.load(std::memory_order_relaxed); }
+
+ private:
+   std::atomic<std::uint64_t> _value{0}; ///< value
+};
+
+/**
+ * Counters and latencies of the Logger measured in one thread
+ *
+ * Counters include every log, latencies are measured for every SAMPLE-th log of
+ * the thread only (reading the clock costs more than counting).
+ */
+struct ThreadStats
+{
+   static const std::uint64_t SAMPLE = 16; ///< logs per latency measurement
+
+   /**
+    * Starts log of thread, selects every SAMPLE-th log for latency measurement
+    *
+    * @return true if latencies of this log are measured
+    */
+   bool begin()
+   {
+      const std::uint64_t n = ticks.get();
+      ticks.add(1);
+      const bool sample = n % SAMPLE == 0;
+      timed.store(sample, std::memory_order_relaxed);
+      return sample;
+   }
+
+   /**
+    * Proves if latencies of current log are measured, see begin()
+    *
+    * @return true if measured
+    */
+   bool isTimed() const { return timed.load(std::memory_order_relaxed); }
+
+   SharedCounter ticks;            ///< logs started with begin()
+   std::atomic<bool> timed{false}; ///< latencies of current log are measured
+   SharedCounter records[4];       ///< logs of INFO, DEBUG, WARN, ERROR
+   SharedCounter bytes_formatted;  ///< bytes of submitted messages
+   SharedCounter bytes_written;    ///< bytes written to log file by this thread
+   SharedCounter suppressed;       ///< dropped by deduplication or rate limits
+   SharedCounter queue_max;        ///< largest async queue depth seen on enqueue
+   SharedHistogram call;           ///< [ns] in Logger per log, after formatting
+   SharedHistogram lock_wait;      ///< [ns] waiting for the Logger mutex
+   SharedHistogram lock_hold;      ///< [ns] holding the Logger mutex per log
+   SharedHistogram enqueue;        ///< [ns] enqueueing in async mode
+   SharedHistogram flush;          ///< [ns] per write of stored logs to file
+};
+
+/**
+ * @brief Snapshot of the self-instrumentation of the Logger, see
+ * Logger::enableStats() and Logger::getStats()
+ *
+ * Values are totals since the statistics were enabled, of all threads (also of
+ * threads that have ended). Latencies are in nanoseconds, the histograms call,
+ * lock_wait, lock_hold and enqueue hold every ThreadStats::SAMPLE-th log of each
+ * thread, flush holds every write of the log file.
+ *
+ * @author MSC
+ */
+struct LogStats
+{
+   double elapsed = 0.0;                ///< [s] since statistics were enabled
+   std::uint64_t records[4] = {};       ///< logs of INFO, DEBUG, WARN, ERROR
+   std::uint64_t bytes_formatted = 0;   ///< bytes of submitted messages
+   std::uint64_t bytes_written   = 0;   ///< bytes written to log file
+   std::uint64_t suppressed      = 0;   ///< dropped by deduplication, rate limits
+   std::uint64_t dropped         = 0;   ///< async queue full, no memory, no file
+   std::uint64_t console_dropped = 0;   ///< terminal too slow
+   std::uint64_t console_stalls  = 0;   ///< waits for terminal (blocking console)
+   std::uint64_t console_stall_ns = 0;  ///< [ns] waited for terminal
+   std::uint64_t sink_dropped = 0;      ///< sink queues full
+   std::uint64_t queue_depth  = 0;      ///< logs in async queue now
+   std::uint64_t queue_max    = 0;      ///< largest async queue depth
+   Histogram call;      ///< [ns] in Logger per log, after formatting
+   Histogram lock_wait; ///< [ns] waiting for the Logger mutex
+   Histogram lock_hold; ///< [ns] holding the Logger mutex per log
+   Histogram enqueue;   ///< [ns] enqueueing in async mode
+   Histogram flush;     ///< [ns] per write of stored logs to file
+
+   /**
+    * Getter for number of logs of all levels
+    *
+    * @return logs
+    */
+   std::uint64_t total() const
+   {
+      return records[0] + records[1] + records[2] + records[3];
+   }
+
+   /**
+    * Getter for time logging threads spent in the Logger relative to the elapsed
+    * time
+    *
+    * Sum of sampled call times of all threads, scaled by ThreadStats::SAMPLE and
+    * divided by elapsed time, i.e. the mean number of threads inside the Logger.
+    * Waits for the mutex, a full async queue or a blocking terminal and writes of
+    * the log file in sync mode are included, the consumer thread of async mode
+    * and formatting before the message is passed to the Logger are not. As call
+    * times are sampled, single long calls distort short intervals.
+    *
+    * @return share, e.g. 0.01 if logging takes 1 % of the time of one thread
+    */
+   double busyShare() const
+   {
+      if(elapsed <= 0.0)
+      {
+         return 0.0;
+      }
+      const double ns = static_cast<double>(call.sum() * ThreadStats::SAMPLE);
+      return ns * 1e-9 / elapsed;
+   }
+
+   /**
+    * Formats summary line as logged periodically
+    *
+    * @return summary
+    */
+   std::string toString() const
+   {
+      char buf[512];
+      std::snprintf(
+          buf, sizeof(buf),
+          "logger stats %.1f s: %llu logs (INFO %llu DEBUG %llu WARN %llu "
+          "ERROR %llu), %.2f MiB formatted, %.2f MiB written, busy %.3f %%, "
+          "call p50 %s p99 %s, lock wait p99 %s, flush %llu x p99 %s, "
+          "dropped %llu, suppressed %llu, console dropped %llu stalls %llu, "
+          "sinks dropped %llu, queue %llu (max %llu)",
+          elapsed, LogStats::ull(this->total()), LogStats::ull(records[0]),
+          LogStats::ull(records[1]), LogStats::ull(records[2]),
+          LogStats::ull(records[3]),
+          static_cast<double>(bytes_formatted) / 1048576.0,
+          static_cast<double>(bytes_written) / 1048576.0, this->busyShare() * 100.0,
+          LogStats::ns(call, 0.5).c_str(), LogStats::ns(call, 0.99).c_str(),
+          LogStats::ns(lock_wait, 0.99).c_str(), LogStats::ull(flush.count()),
+          LogStats::ns(flush, 0.99).c_str(), LogStats::ull(dropped),
+          LogStats::ull(suppressed), LogStats::ull(console_dropped),
+          LogStats::ull(console_stalls), LogStats::ull(sink_dropped),
+          LogStats::ull(queue_depth), LogStats::ull(queue_max));
+      return buf;
+   }
+
+ private:
+   static unsigned long long ull(const std::uint64_t value)
+   {
+      return static_cast<unsigned long long>(value);
+   }
+
+   static std::string ns(const Histogram& h, const double p)
+   {
+      return Histogram::formatNs(static_cast<double>(h.percentile(p)));
+   }
+};
+
+/**
+ * @brief Registry of the ThreadStats of all threads
+ *
+ * Each thread gets its ThreadStats on first use (see ThreadRegistry), they are
+ * summed by collect(). When a thread ends, its values are kept in the registry.
+ * Logs after the thread locals of a thread were destroyed are not counted.
+ * Nothing is measured unless enabled(), the check is a single relaxed load.
+ *
+ * @author MSC
+ */
+class StatsRegistry
+{
+ public:
+   /**
+    * Proves if statistics are collected
+    *
+    * @return true if enabled
+    */
+   static bool enabled()
+   {
+      return StatsRegistry::flag().load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Enables or disables collection, values are kept
+    *
+    * @param[in] enable true to collect
+    */
+   static void setEnabled(const bool enable)
+   {
+      StatsRegistry::flag().store(enable, std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for statistics of calling thread
+    *
+    * @return statistics, nullptr after destruction of thread locals (e.g. in
+    * destructors of static objects) or if out of memory
+    */
+   static ThreadStats* local() noexcept { return Threads::local(); }
+
+   /**
+    * Getter for statistics of calling thread if collection is enabled
+    *
+    * @return statistics, nullptr if disabled or see local()
+    */
+   static ThreadStats* active() noexcept
+   {
+      return StatsRegistry::enabled() ? Threads::local() : nullptr;
+   }
+
+   /**
+    * Adds values of all threads to given snapshot
+    *
+    * @param[in, out] out snapshot
+    */
+   static void collect(LogStats& out)
+   {
+      Threads::visit(
+          [&out](const Ended& ended, const std::vector<ThreadStats*>& threads) {
+             StatsRegistry::merge(out, ended.stats);
+             for(const ThreadStats* stats : threads)
+             {
+                StatsRegistry::add(out, *stats);
+             }
+          });
+   }
+
+ private:
+   /**
+    * Sums of ended threads
+    */
+   struct Ended
+   {
+      LogStats stats; ///< sums of ended threads
+
+      void attach(ThreadStats&) {}
+
+      void retire(const ThreadStats& thread) { StatsRegistry::add(stats, thread); }
+   };
+
+   using Threads = ThreadRegistry<ThreadStats, Ended>; ///< stats of all threads
+
+   static std::atomic<bool>& flag()
+   {
+      static std::atomic<bool> flag(false);
+      return flag;
+   }
+
+   /**
+    * Adds values of thread to snapshot
+    */
+   static void add(LogStats& out, const ThreadStats& stats)
+   {
+      for(int i = 0; i < 4; i++)
+      {
+         out.records[i] += stats.records[i].get();
+      }
+      out.bytes_formatted += stats.bytes_formatted.get();
+      out.bytes_written += stats.bytes_written.get();
+      out.suppressed += stats.suppressed.get();
+      out.queue_max = std::max(out.queue_max, stats.queue_max.get());
+      stats.call.collect(out.call);
+      stats.lock_wait.collect(out.lock_wait);
+      stats.lock_hold.collect(out.lock_hold);
+      stats.enqueue.collect(out.enqueue);
+      stats.flush.collect(out.flush);
+   }
+
+   /**
+    * Adds sums of ended threads to snapshot
+    */
+   static void merge(LogStats& out, const LogStats& ended)
+   {
+      for(int i = 0; i < 4; i++)
+      {
+         out.records[i] += ended.records[i];
+      }
+      out.bytes_formatted += ended.bytes_formatted;
+      out.bytes_written += ended.bytes_written;
+      out.suppressed += ended.suppressed;
+      out.queue_max = std::max(out.queue_max, ended.queue_max);
+      out.call.merge(ended.call);
+      out.lock_wait.merge(ended.lock_wait);
+      out.lock_hold.merge(ended.lock_hold);
+      out.enqueue.merge(ended.enqueue);
+      out.flush.merge(ended.flush);
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOLOGSTATS_H_ */
@@ -0,0 +1,168 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOLOGSTREAM_H_
+#define EVOLOGSTREAM_H_
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace evo {
+
+/**
+ * @brief Growing stream buffer which is reused for every message
+ *
+ * Memory is only allocated while the buffer grows, reset() keeps the capacity, so
+ * streaming a message is allocation free once the longest message fit in.
+ *
+ * @author MSC
+ */
+class LogStreamBuf : public std::streambuf
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] capacity initial capacity in bytes
+    */
+   explicit LogStreamBuf(const std::size_t capacity = 256) : _buf(capacity)
+   {
+      this->reset();
+   }
+
+   /**
+    * Getter for streamed data, not null terminated
+    *
+    * @return pointer to first char
+    */
+   const char* data() const { return this->pbase(); }
+
+   /**
+    * Getter for size of streamed data
+    *
+    * @return number of chars
+    */
+   std::size_t size() const
+   {
+      return static_cast<std::size_t>(this->pptr() - this->pbase());
+   }
+
+   /**
+    * Discards streamed data, capacity is kept
+    */
+   void reset() { this->setp(_buf.data(), _buf.data() + _buf.size()); }
+
+ protected:
+   int_type overflow(int_type ch) override
+   {
+      if(traits_type::eq_int_type(ch, traits_type::eof()))
+      {
+         return traits_type::not_eof(ch);
+      }
+      this->grow(1);
+      *this->pptr() = traits_type::to_char_type(ch);
+      this->pbump(1);
+      return ch;
+   }
+
+   std::streamsize xsputn(const char* s, std::streamsize n) override
+   {
+      if(this->epptr() - this->pptr() < n)
+      {
+         this->grow(static_cast<std::size_t>(n));
+      }
+      std::memcpy(this->pptr(), s, static_cast<std::size_t>(n));
+      this->pbump(static_cast<int>(n));
+      return n;
+   }
+
+ private:
+   /**
+    * Enlarges buffer, keeps streamed data
+    *
+    * @param[in] n number of chars which have to fit in additionally
+    */
+   void grow(const std::size_t n)
+   {
+      const std::size_t used = this->size();
+      _buf.resize(std::max(_buf.size() * 2, used + n));
+      this->setp(_buf.data(), _buf.data() + _buf.size());
+      this->pbump(static_cast<int>(used));
+   }
+
+   std::vector<char> _buf; ///< storage, only grows
+};
+
+/**
+ * @brief Per-thread ostream for building log messages
+ *
+ * Every thread streams into its own instance (see local()), so messages of
+ * different threads can not interleave. The stream is reset after each message.
+ *
+ * @author MSC
+ */
+class LogStream : public std::ostream
+{
+ public:
+   /**
+    * Constructor
+    */
+   LogStream() : std::ostream(&_buf) {}
+
+   LogStream(const LogStream&) = delete;
+   LogStream& operator=(const LogStream&) = delete;
+
+   /**
+    * Getter for stream of calling thread
+    *
+    * @return thread local instance
+    */
+   static LogStream& local()
+   {
+      thread_local LogStream stream;
+      return stream;
+   }
+
+   /**
+    * Getter for streamed message, valid until reset()
+    *
+    * @return pointer to first char, not null terminated
+    */
+   const char* data() const { return _buf.data(); }
+
+   /**
+    * Getter for size of streamed message
+    *
+    * @return number of chars
+    */
+   std::size_t size() const { return _buf.size(); }
+
+   /**
+    * Copies streamed message
+    *
+    * @return message as std::string
+    */
+   std::string str() const { return std::string(_buf.data(), _buf.size()); }
+
+   /**
+    * Discards streamed message and clears error state, keeps capacity
+    */
+   void reset()
+   {
+      _buf.reset();
+      this->clear();
+   }
+
+ private:
+   LogStreamBuf _buf; ///< reusable buffer
+};
+
+} // namespace evo
+
+#endif /* EVOLOGSTREAM_H_ */
@@ -6,6 +6,7 @@
 #ifndef LOGTYPE_H_
 #define LOGTYPE_H_
 
+#include <cstring>
 #include <vector>
 #include <string>
 
@@ -42,24 +43,116 @@ static std::vector<std::string> LEVEL_STR = {
  */
 struct LogObj
 {
-   evo::Time stamp;        ///< Timestamp for log
-   Log::Log level;         ///< Loglevel for log
-   const std::string text; ///< Logmessage for log
+   evo::Time stamp;  ///< Timestamp for log
+   Log::Log level;   ///< Loglevel for log
+   std::string text; ///< Logmessage for log
 
    /**
-    * Parse function to convert LogObj to String (for terminal and file output)
+    * Parse function to convert LogObj to String (for terminal and file output),
+    * timestamp precision is set by TimeFormatter::setPrecision()
     *
     * @param[in] obj object to parse
     * @return string parsed from Logobj
     */
    static std::string parse(const LogObj& obj)
    {
-      std::string str = std::string("[") + evo::Time::toString(obj.stamp) +
-                        std::string("]-[") +
-                        std::string(LEVEL_STR[static_cast<LogType>(obj.level)]) +
-                        std::string("]  ") + obj.text;
+      std::string str;
+      LogObj::parse(str, obj.stamp, obj.level, obj.text.data(), obj.text.size());
       return str;
    }
+
+   /**
+    * Parse function for logs not stored as LogObj, reuses memory of given string
+    *
+    * @param[out] str   string parsed from log, previous content is replaced
+    * @param[in]  stamp timestamp of log
+    * @param[in]  level log level of log
+    * @param[in]  text  pointer to log message
+    * @param[in]  len   length of log message
+    */
+   static void parse(std::string& str, const evo::Time& stamp, Log::Log level,
+                     const char* text, const std::size_t len)
+   {
+      LogObj::parse(str, stamp.toNSec(), level, text, len);
+   }
+
+   /**
+    * Parse function for logs not stored as LogObj, reuses memory of given string
+    *
+    * @param[out] str   string parsed from log, previous content is replaced
+    * @param[in]  ns    timestamp of log as nanoseconds since epoch
+    * @param[in]  level log level of log
+    * @param[in]  text  pointer to log message
+    * @param[in]  len   length of log message
+    * @param[in]  where location "file:line" printed before message, may be nullptr
+    */
+   static void parse(std::string& str, const std::int64_t ns, Log::Log level,
+                     const char* text, const std::size_t len,
+                     const char* where = nullptr)
+   {
+      str.assign(1, '[');
+      TimeFormatter::append(str, ns);
+      str += "]-[";
+      str += LEVEL_STR[static_cast<LogType>(level)];
+      str += "]  ";
+      if(where)
+      {
+         str += where;
+         str += ": ";
+      }
+      str.append(text, len);
+   }
+
+   /**
+    * Parse function writing into given buffer, not null terminated
+    *
+    * @param[out] buf   buffer with at least maxLength(len) chars
+    * @param[in]  ns    timestamp of log as nanoseconds since epoch
+    * @param[in]  level log level of log
+    * @param[in]  text  pointer to log message
+    * @param[in]  len   length of log message
+    * @param[in]  where location "file:line" printed before message, may be
+    * nullptr, shorter than WHERE_LENGTH
+    * @return number of chars written
+    */
+   static std::size_t parse(char* buf, const std::int64_t ns, Log::Log level,
+                            const char* text, const std::size_t len,
+                            const char* where = nullptr)
+   {
+      const std::string& level_str = LEVEL_STR[static_cast<LogType>(level)];
+      std::size_t pos              = 0;
+      buf[pos++]                   = '[';
+      pos += TimeFormatter::format(buf + pos, ns, TimeFormatter::getPrecision());
+      std::memcpy(buf + pos, "]-[", 3);
+      pos += 3;
+      std::memcpy(buf + pos, level_str.data(), level_str.size());
+      pos += level_str.size();
+      std::memcpy(buf + pos, "]  ", 3);
+      pos += 3;
+      if(where)
+      {
+         const std::size_t n = std::strlen(where);
+         std::memcpy(buf + pos, where, n);
+         std::memcpy(buf + pos + n, ": ", 2);
+         pos += n + 2;
+      }
+      std::memcpy(buf + pos, text, len);
+      return pos + len;
+   }
+
+   /**
+    * Maximum length of a parsed log
+    *
+    * @param[in] len length of log message
+    * @return max number of chars written by parse()
+    */
+   static std::size_t maxLength(const std::size_t len)
+   {
+      // brackets, separators, level, location
+      return TimeFormatter::MAX_LENGTH + len + 12 + WHERE_LENGTH + 2;
+   }
+
+   static const std::size_t WHERE_LENGTH = 48; ///< max length of location + 1
 };
 
 } // namespace evo
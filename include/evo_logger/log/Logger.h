@@ -17,10 +17,32 @@
 #include <stdexcept>
 #include <thread>
 #include <mutex>
-
+#include <atomic>
+#include <condition_variable>
+#include <initializer_list>
+
+#include "evo_logger/log/BinaryLog.h"
+#include "evo_logger/log/Callsite.h"
+#include "evo_logger/log/Channel.h"
+#include "evo_logger/log/ConsoleSink.h"
+#include "evo_logger/log/Deduplicator.h"
+#include "evo_logger/log/Encoder.h"
+#include "evo_logger/log/Field.h"
+#include "evo_logger/log/FlightRecorder.h"
+#include "evo_logger/log/FlushPolicy.h"
+#include "evo_logger/log/Format.h"
+#include "evo_logger/log/LogArchiver.h"
+#include "evo_logger/log/LogStats.h"
 #include "evo_logger/log/LogType.h"
+#include "evo_logger/log/LogStream.h"
+#include "evo_logger/log/MmapWriter.h"
+#include "evo_logger/log/MpscQueue.h"
+#include "evo_logger/log/RecordStore.h"
+#include "evo_logger/log/RotationPolicy.h"
+#include "evo_logger/log/Sinks.h"
 #include "evo_logger/log/Writer.h"
 #include "evo_logger/log/OstreamColor.h"
+#include "evo_logger/time/Clock.h"
 #include "evo_logger/time/Time.h"
 #include "evo_logger/base/Utility.h"
 
@@ -29,21 +51,34 @@ namespace evo {
 static const std::string LOG_FOLDER =
     ".evocortex"; ///< Folder in Homedir where log-file are stored
 
+/**
+ * Passes summaries of all rate limited call sites with suppressed calls to
+ * report, defined in RateLimit.h (see RateLimit::summarize())
+ *
+ * @param[in] report called with each summary message
+ */
+template<typename F>
+void summarizeRateLimits(F report);
+
 /**
  * @brief Class for Logging as Singleton.
  *
  * This Logger stores all logs and writes all Logs in to a file (append). The log
  * files are stored in "homdir/.evocortex/". The class evo::log is a simple wrapper
- * for the Logger for easy usage. Log levels can only be changed for terminal output.
+ * for the Logger for easy usage. Log levels are set separately for terminal output
+ * (setLogLevel()) and file (setFileLogLevel()), a log enabled for neither is
+ * dropped.
  *
  * Logger uses ostream for stream logging, so every object with overloaded ostream is
- * accepted.
+ * accepted. Each thread streams into its own reusable LogStream, so messages of
+ * concurrent threads do not interleave.
  *
  * Recommended usage:
  *
  * log initialize:
  * @code
  * evo::log::init("Logger-name");
+ * evo::log::init("Logger-name", evo::FileMode::MMAP); // memory mapped log file
  * @endcode
  *
  * log stream:
@@ -65,22 +100,78 @@ static const std::string LOG_FOLDER =
  * evo::error(std::string("warn-msg");
  * @endcode
  *
- * write log-file
+ * level macros, arguments are only evaluated if the level is enabled, levels below
+ * EVO_LOG_MIN_LEVEL are removed at compile time (see LogMacros.h)
+ * @code
+ * EVO_DEBUG("printf-syntax %f", expensive());
+ * EVO_WARN_STREAM("stream " << someData);
+ * @endcode
+ *
+ * write log-file, stored logs are also written when a trigger of FlushPolicy fires
  * @code
  * evo::log::writeLog();
  * @endcode
  *
+ * additional outputs with own level mask and queue (see Sinks.h), each log is
+ * formatted once for all sinks
+ * @code
+ * evo::log::get().addSink(
+ *     std::make_shared<evo::StreamSink>(std::cerr, evo::Log::ERROR));
+ * evo::log::get().addSink(std::make_shared<evo::SocketSink>("/tmp/evo.sock"));
+ * @endcode
+ *
+ * deduplication (identical consecutive messages are collapsed into one summary
+ * "last message repeated N times")
+ * @code
+ * evo::log::get().enableDedup();
+ * @endcode
+ *
+ * flight recorder (latest logs survive a crash, recover with evo_log_recover)
+ * @code
+ * evo::log::get().enableFlightRecorder();
+ * @endcode
+ *
+ * log rotation (new file every 100 MiB, closed files are compressed, keep 20)
+ * @code
+ * evo::RotationPolicy policy;
+ * policy.max_bytes = 100 << 20;
+ * policy.max_files = 20;
+ * evo::log::get().setRotationPolicy(policy);
+ * @endcode
+ *
+ * asynchronous mode (producers only enqueue, a background thread prints and stores)
+ * @code
+ * evo::log::get().enableAsync();
+ * @endcode
+ *
+ * binary mode (printf-style logs are stored unformatted in a .blog file, decode
+ * with evo_log_decoder)
+ * @code
+ * evo::log::get().enableBinary();
+ * @endcode
+ *
+ * TSC timestamps (raw CPU ticks are stored, converted when written, see Clock)
+ * @code
+ * evo::Clock::enableTsc();
+ * @endcode
+ *
+ * self-instrumentation (see LogStats), summary logged every 60 s
+ * @code
+ * evo::log::get().enableStats(60.0);
+ * evo::LogStats stats = evo::log::get().getStats();
+ * @endcode
+ *
+ * named channels with inherited level masks (see Channel)
+ * @code
+ * evo::Channel& lidar = evo::log::channel("driver.lidar");
+ * EVO_CH_DEBUG(lidar, "scan %d", n); // "[driver.lidar] scan 42"
+ * @endcode
+ *
  * @todo thread safe impl (thread c++11)
- * @todo preprocessor exclude for debug in release mode
- * @todo safe before program exit -> save after each log or something... maybe extra
- * mode...
- * @todo add kind of __pretty_function__ style in logger output (origin-> line
- * file... )
- * @todo sublogger
  *
  * @author MSC
  */
-class Logger : public std::basic_stringstream<char>
+class Logger
 {
  public:
    /**
@@ -94,190 +185,1577 @@ class Logger : public std::basic_stringstream<char>
    Logger(Logger&&) = delete;
 
    /**
-    * =operator(copy) deleted -> Singleton
+    * =operator(copy) deleted -> Singleton
+    */
+   Logger& operator=(const Logger&) = delete;
+
+   /**
+    * =operator(move) deleted -> Singleton
+    */
+   Logger& operator=(Logger&&) = delete;
+
+   /**
+    * Singleton pattern
+    *
+    * @return Instance from Logger
+    */
+   static inline Logger& instance()
+   {
+      static Logger instance;
+      return instance;
+   }
+
+   /**
+    * Initialize Logger, has only on first call an effect
+    *
+    * @param[in] name name of program or user defined name
+    * @param[in] mode writer for log file, FileMode::MMAP for large amounts of logs
+    */
+   void initialize(const std::string& name,
+                   const FileMode::FileMode mode = FileMode::STREAM)
+   {
+      // set only once
+      if(_writer)
+      {
+         return;
+      }
+
+      _name = name;
+
+      std::string log_folder = Utility::getHomeDir() + "/" + LOG_FOLDER + "/";
+
+      // prove folder exists
+      if(!Utility::directoryExists(log_folder))
+      {
+         // create log folder
+         // linux
+         if(mkdir(log_folder.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 ||
+            (!Utility::directoryExists(log_folder)))
+         {
+            _os << "LOG_FOLDER could not be set.... take current Direktory"
+                << std::endl;
+            log_folder = "";
+         }
+      }
+
+      // get name for logfile:
+      std::string log_file(
+          TimeFormatter::toString(evo::Time::now().toNSec(), TimeFormatter::SEC) +
+          std::string("-") + _name);
+
+      _log_folder    = log_folder;
+      _file_base     = log_folder + log_file;
+      _file_mode     = mode;
+      _writer        = this->createWriter(_file_base + ".log");
+      _segment_start = Clock::nowNSec();
+   }
+
+ private:
+   /**
+    * Default private Constructor -> Singleton
+    */
+   Logger() :
+       _os(std::cout), _color_def_f(OSColor(Color::F_DEFAULT)),
+       _color_def_b(OSColor(Color::B_DEFAULT)),
+       _color_info_f(OSColor(Color::F_DEFAULT)),
+       _color_info_b(OSColor(Color::B_DEFAULT)),
+       _color_debug_f(OSColor(Color::F_LIGHT_BLUE)),
+       _color_debug_b(OSColor(Color::B_DEFAULT)),
+       _color_warn_f(OSColor(Color::F_LIGHT_RED)),
+       _color_warn_b(OSColor(Color::B_DEFAULT)),
+       _color_error_f(OSColor(Color::F_DEFAULT)),
+       _color_error_b(OSColor(Color::B_RED))
+   {
+      // escape sequences are precomputed once
+      _console.setDefaultColors(_color_def_f, _color_def_b);
+      _console.setColors(Log::INFO, _color_info_f, _color_info_b);
+      _console.setColors(Log::DEBUG, _color_debug_f, _color_debug_b);
+      _console.setColors(Log::WARN, _color_warn_f, _color_warn_b);
+      _console.setColors(Log::ERROR, _color_error_f, _color_error_b);
+   }
+
+   /**
+    * Destructor writes Logs to file
+    */
+   ~Logger()
+   {
+      this->flushSuppressed();
+      this->flushRepeats();
+      this->stopAsync();
+      this->flush();
+      this->closeWriter();
+      this->stopSinks();
+      _binary.reset();
+      _flight.reset(); // logs are in log file, removes ring file
+      _archiver.reset();
+   }
+
+   /**
+    * forces ERROR output, even if it is disabled
+    *
+    * @todo check if needed
+    */
+   void forceOutput()
+   {
+      _current_log_level.fetch_or(static_cast<LogType>(Log::ERROR),
+                                  std::memory_order_relaxed);
+   }
+
+   /**
+    * Recomputes _enabled_log_level after a change of the level masks
+    */
+   void updateEnabledLevel()
+   {
+      std::lock_guard<std::mutex> lock(_level_mutex);
+      _enabled_log_level.store(_current_log_level.load(std::memory_order_relaxed) |
+                                   _file_log_level.load(std::memory_order_relaxed) |
+                                   _sink_log_level.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+   }
+
+   RecordStore _logs; ///< Container for logs
+
+   ConsoleSink _console; ///< batched terminal output
+
+   FlushPolicy _flush_policy; ///< triggers for writing _logs
+
+   std::int64_t _last_flush = Clock::nowNSec(); ///< time [ns] of last write of _logs
+
+   std::atomic<LogType> _current_log_level{Log::ALL}; ///< Log level for terminal
+
+   std::atomic<LogType> _file_log_level{Log::ALL}; ///< Log level stored for file
+
+   /// union of terminal, file and sink levels, checked before formatting
+   std::atomic<LogType> _enabled_log_level{Log::ALL};
+
+   std::mutex _level_mutex; ///< serializes updates of _enabled_log_level
+
+   std::string _name; ///< name of Logger
+
+   std::unique_ptr<Writer> _writer; ///< Writer Object
+
+   bool _write_failed = false; ///< last write to file failed, error was reported
+
+   std::string _file_base; ///< log file path without extension
+
+   std::string _log_folder; ///< folder of log files
+
+   FileMode::FileMode _file_mode = FileMode::STREAM; ///< writer for log file
+
+   RotationPolicy _rotation; ///< triggers for new segment, retention limits
+
+   std::int64_t _segment_start = 0; ///< time [ns] current segment was started
+
+   unsigned int _segment = 0; ///< number of current segment
+
+   std::unique_ptr<LogArchiver> _archiver; ///< compresses and deletes old segments
+
+   std::unique_ptr<BinaryLog> _binary; ///< binary log for binary mode
+   std::atomic<bool> _binary_on{false}; ///< true if binary mode is enabled
+
+   std::unique_ptr<Deduplicator> _dedup; ///< collapses repeated messages
+   std::atomic<bool> _dedup_on{false};   ///< true if deduplication is enabled
+
+   std::unique_ptr<FlightRecorder> _flight; ///< crash surviving ring of latest logs
+   std::atomic<bool> _flight_on{false};     ///< true if flight recorder is enabled
+
+   std::atomic<std::int64_t> _stats_start{0};    ///< time [ns] stats were enabled
+   std::atomic<std::int64_t> _stats_interval{0}; ///< [ns] between stats summaries
+   std::atomic<std::int64_t> _stats_next{0};     ///< time [ns] of next summary
+
+   std::shared_ptr<const std::vector<std::shared_ptr<Sink>>>
+       _sinks; ///< additional outputs, replaced on change (copy on write)
+   std::atomic<LogType> _sink_log_level{0}; ///< levels accepted by any sink
+   std::mutex _sink_mutex;                  ///< serializes changes of _sinks
+
+   std::ostream& _os; ///< ostream
+
+   std::mutex _mutex; ///< mutex for thread safety (c++11)
+
+   /**
+    * Log in async queue, timestamp is converted by the consumer
+    *
+    * A marker (see waitAsync()) carries no log, the consumer sets its flag when
+    * it reaches it.
+    */
+   struct QueuedLog
+   {
+      std::uint64_t stamp;       ///< raw timestamp (see Clock)
+      Log::Log level;            ///< log level
+      std::string text;          ///< log message
+      const Callsite* site;      ///< call site, nullptr if unknown
+      std::atomic<bool>* marker; ///< flag of waiting thread, nullptr for logs
+   };
+
+   std::unique_ptr<MpscQueue<QueuedLog>> _queue; ///< queue for async mode
+   std::atomic<bool> _async{false};           ///< true if async mode is running
+   std::atomic<bool> _async_stop{false};      ///< stops consumer thread
+   bool _async_block = true; ///< producers wait if queue is full, else drop
+   std::thread _consumer;    ///< consumer thread for async mode
+   std::mutex _async_mutex;  ///< mutex for consumer notification only
+   std::condition_variable _async_cv;         ///< wakes consumer and flushers
+   std::atomic<std::uint64_t> _async_pushed{0};  ///< records enqueued
+   std::atomic<std::uint64_t> _async_done{0};    ///< records stored by consumer
+   std::atomic<std::uint64_t> _dropped{0};    ///< records dropped (full, no memory, no file)
+
+   OSColor _color_def_f;   ///< default color foreground
+   OSColor _color_def_b;   ///< default color background
+   OSColor _color_info_f;  ///< info color foreground
+   OSColor _color_info_b;  ///< info color background
+   OSColor _color_debug_f; ///< debug color foreground
+   OSColor _color_debug_b; ///< debug color background
+   OSColor _color_warn_f;  ///< warn color foreground
+   OSColor _color_warn_b;  ///< warn color background
+   OSColor _color_error_f; ///< error color foreground
+   OSColor _color_error_b; ///< error color background
+
+   /**
+    * Saves log and writes it to terminal if its level is enabled, caller has to
+    * hold _mutex
+    *
+    * @param[in] stamp raw timestamp of log (see Clock)
+    * @param[in] level log level of log
+    * @param[in] text  pointer to log message
+    * @param[in] len   length of log message
+    * @param[in] site  call site, may be nullptr
+    */
+   void store(const std::uint64_t stamp, Log::Log level, const char* text,
+              const std::size_t len, const Callsite* site)
+   {
+      const std::int64_t ns = Clock::toNSec(stamp);
+      const bool forced     = Callsite::forced(site);
+      if(forced || this->isPrinted(level))
+      {
+         _console.write(level, ns, text, len, Callsite::location(site));
+      }
+      if(!forced && !this->isStored(level))
+      {
+         return;
+      }
+      try
+      {
+         _logs.append(stamp, level, text, len, site);
+      } catch(std::bad_alloc& e)
+      {
+         // write stored logs to release their memory, then try again
+         this->flush();
+         _logs.release();
+         try
+         {
+            _logs.append(stamp, level, text, len, site);
+         } catch(std::bad_alloc& e)
+         {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+         }
+      }
+      // before initialize() logs stay in store as the file name is not known yet,
+      // up to storeLimit(), then flush() names the file after "EVO"
+      if(_writer ? _flush_policy.due(_logs.size(), _logs.bytes(),
+                                     static_cast<double>(ns - _last_flush) * 1e-9,
+                                     level)
+                 : _logs.bytes() >= this->storeLimit())
+      {
+         this->flush();
+      }
+   }
+
+   /**
+    * Passes log to flight recorder, sinks, binary log, async queue or store
+    *
+    * @param[in] stamp raw timestamp of log (see Clock)
+    * @param[in] level log level of log
+    * @param[in] text  pointer to log message
+    * @param[in] len    length of log message
+    * @param[in] site   call site, may be nullptr
+    * @param[in] fields fields of structured log (appended to text), may be nullptr
+    */
+   void process(const std::uint64_t stamp, Log::Log level, const char* text,
+                const std::size_t len, const Callsite* site,
+                const FieldRange* fields = nullptr)
+   {
+      const bool flight = _flight_on.load(std::memory_order_acquire);
+      if(flight || this->isDispatched(level))
+      {
+         const std::int64_t ns = Clock::toNSec(stamp);
+         if(flight)
+         {
+            _flight->append(ns, level, text, len);
+         }
+         this->dispatch(ns, level, text, len, site, fields);
+      }
+      if(_binary_on.load(std::memory_order_acquire))
+      {
+         const bool forced = Callsite::forced(site);
+         if(forced || this->isStored(level))
+         {
+            _binary->append(level, "%s", BinaryLog::Text{text, len});
+         }
+         if(forced || this->isPrinted(level))
+         {
+            _console.write(level, Clock::toNSec(stamp), text, len,
+                           Callsite::location(site));
+         }
+         return;
+      }
+      if(_async.load(std::memory_order_acquire))
+      {
+         this->enqueue(
+             QueuedLog{stamp, level, std::string(text, len), site, nullptr});
+         return;
+      }
+      ThreadStats* stats = StatsRegistry::active();
+      if(stats && stats->isTimed())
+      {
+         this->storeMeasured(*stats, stamp, level, text, len, site);
+         return;
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      this->store(stamp, level, text, len, site);
+   }
+
+   /**
+    * Takes _mutex and stores log like process(), measures lock wait and hold time
+    * in statistics of calling thread
+    */
+   void storeMeasured(ThreadStats& stats, const std::uint64_t stamp, Log::Log level,
+                      const char* text, const std::size_t len, const Callsite* site)
+   {
+      const std::int64_t start = Clock::nowNSec();
+      std::lock_guard<std::mutex> lock(_mutex);
+      const std::int64_t locked = Clock::nowNSec();
+      this->store(stamp, level, text, len, site);
+      stats.lock_wait.add(static_cast<std::uint64_t>(locked - start));
+      stats.lock_hold.add(static_cast<std::uint64_t>(Clock::nowNSec() - locked));
+   }
+
+   /**
+    * Appends fields of structured log to message and submits it
+    *
+    * @param[in] channel channel printed in front of message, may be nullptr
+    * @param[in] level   log level of log
+    * @param[in] msg     log message
+    * @param[in] fields  fields of log
+    * @param[in] site    call site, may be nullptr
+    */
+   void submitFields(const Channel* channel, Log::Log level, const char* msg,
+                     std::initializer_list<Field> fields, const Callsite* site)
+   {
+      FormatBuffer& buf = FormatBuffer::local();
+      buf.clear();
+      if(channel)
+      {
+         buf.append(channel->prefix().data(), channel->prefix().size());
+      }
+      buf.append(msg, std::strlen(msg));
+      const FieldRange range = {fields.begin(), fields.size(), buf.size()};
+      Encoder::appendFields(buf, fields.begin(), fields.size());
+      this->submit(level, buf.data(), buf.size(), site, &range);
+   }
+
+   /**
+    * Passes enabled log to deduplication and process()
+    */
+   void submit(Log::Log level, const char* text, const std::size_t len,
+               const Callsite* site, const FieldRange* fields)
+   {
+      const std::uint64_t stamp = Clock::raw();
+      ThreadStats* stats = StatsRegistry::active();
+      if(stats)
+      {
+         stats->begin();
+      }
+      if(_dedup_on.load(std::memory_order_acquire))
+      {
+         const std::int64_t ns = Clock::toNSec(stamp);
+         this->expireRepeats(ns);
+         std::string summary;
+         const bool repeat = _dedup->repeated(level, site, text, len, ns, summary);
+         if(!summary.empty())
+         {
+            this->process(stamp, level, summary.data(), summary.size(), nullptr);
+         }
+         if(repeat)
+         {
+            if(stats)
+            {
+               stats->suppressed.add(1);
+            }
+            return;
+         }
+      }
+      this->process(stamp, level, text, len, site, fields);
+      if(stats)
+      {
+         this->count(*stats, stamp, level, len);
+      }
+   }
+
+   /**
+    * Counts submitted log in statistics of calling thread, for sampled logs also
+    * the call time and logs summary of statistics if its interval elapsed, see
+    * enableStats()
+    *
+    * @param[in] stats statistics of calling thread
+    * @param[in] stamp raw timestamp of log, start of the call
+    * @param[in] level log level of log
+    * @param[in] len   length of log message
+    */
+   void count(ThreadStats& stats, const std::uint64_t stamp, Log::Log level,
+              const std::size_t len)
+   {
+      const int slot = IndexFormat::slot(level);
+      if(slot >= 0)
+      {
+         stats.records[slot].add(1);
+      }
+      stats.bytes_formatted.add(len);
+      if(!stats.isTimed())
+      {
+         return;
+      }
+      stats.timed.store(false, std::memory_order_relaxed);
+      const std::int64_t now = Clock::nowNSec();
+      stats.call.add(static_cast<std::uint64_t>(now - Clock::toNSec(stamp)));
+
+      const std::int64_t interval = _stats_interval.load(std::memory_order_relaxed);
+      std::int64_t next           = _stats_next.load(std::memory_order_relaxed);
+      if(interval > 0 && now >= next &&
+         _stats_next.compare_exchange_strong(next, now + interval,
+                                             std::memory_order_relaxed))
+      {
+         const std::string summary = this->getStats().toString();
+         this->process(Clock::raw(), Log::INFO, summary.data(), summary.size(),
+                       nullptr);
+      }
+   }
+
+   /**
+    * Logs summaries of rate limited call sites with suppressed calls since the
+    * last summary, see RateLimit
+    */
+   void flushSuppressed()
+   {
+      evo::summarizeRateLimits([this](const std::string& summary) {
+         this->process(Clock::raw(), Log::WARN, summary.data(), summary.size(),
+                       nullptr);
+      });
+   }
+
+   /**
+    * Logs summaries of pending runs of repeated messages, see Deduplicator
+    */
+   void flushRepeats()
+   {
+      if(!_dedup_on.load(std::memory_order_acquire))
+      {
+         return;
+      }
+      _dedup->flush([this](Log::Log level, const std::string& summary) {
+         this->process(Clock::raw(), level, summary.data(), summary.size(), nullptr);
+      });
+   }
+
+   /**
+    * Logs summaries of runs of repeated messages older than the max interval of
+    * deduplication, see Deduplicator::expire()
+    *
+    * @param[in] ns current time [ns]
+    */
+   void expireRepeats(const std::int64_t ns)
+   {
+      _dedup->expire(ns, [this](Log::Log level, const std::string& summary) {
+         this->process(Clock::raw(), level, summary.data(), summary.size(), nullptr);
+      });
+   }
+
+   /**
+    * Encodes log once per format and enqueues it for every sink accepting its
+    * level
+    *
+    * @param[in] ns     timestamp of log [ns] since epoch
+    * @param[in] level  log level of log
+    * @param[in] text   pointer to log message
+    * @param[in] len    length of log message
+    * @param[in] site   call site, may be nullptr
+    * @param[in] fields fields of structured log (appended to text), may be nullptr
+    */
+   void dispatch(const std::int64_t ns, Log::Log level, const char* text,
+                 const std::size_t len, const Callsite* site = nullptr,
+                 const FieldRange* fields = nullptr)
+   {
+      if(!this->isDispatched(level))
+      {
+         return;
+      }
+      const auto sinks = std::atomic_load(&_sinks);
+      if(!sinks)
+      {
+         return;
+      }
+      std::shared_ptr<LogLine> lines[3]; // one per LineFormat
+      for(const std::shared_ptr<Sink>& sink : *sinks)
+      {
+         if(!sink->accepts(level))
+         {
+            continue;
+         }
+         const LineFormat::LineFormat format = sink->getFormat();
+         std::shared_ptr<LogLine>& line      = lines[format];
+         if(!line)
+         {
+            line        = std::make_shared<LogLine>();
+            line->ns    = ns;
+            line->level = level;
+            Encoder::encode(line->text, format, ns, level, text, len,
+                            Callsite::location(site), fields);
+         }
+         sink->push(line);
+      }
+   }
+
+   /**
+    * Recomputes _sink_log_level from levels of all sinks
+    */
+   void updateSinkLevel()
+   {
+      std::lock_guard<std::mutex> lock(_sink_mutex);
+      const auto sinks = std::atomic_load(&_sinks);
+      LogType level    = 0;
+      if(sinks)
+      {
+         for(const std::shared_ptr<Sink>& sink : *sinks)
+         {
+            level |= sink->getLevel();
+         }
+      }
+      _sink_log_level.store(level, std::memory_order_relaxed);
+      this->updateEnabledLevel();
+   }
+
+   /**
+    * Writes enqueued logs of all sinks and stops their threads
+    */
+   void stopSinks()
+   {
+      const auto sinks = std::atomic_load(&_sinks);
+      if(!sinks)
+      {
+         return;
+      }
+      for(const std::shared_ptr<Sink>& sink : *sinks)
+      {
+         sink->stop();
+      }
+   }
+
+   /**
+    * Writes stored logs to file, caller has to hold _mutex
+    *
+    * If the file can not be written, the error is reported once on terminal and
+    * the logs are kept for the next try until they exceed storeLimit(), then they
+    * are dropped.
+    */
+   void flush()
+   {
+      if(!_writer)
+      {
+         this->initialize("EVO");
+      }
+      const bool measure        = StatsRegistry::enabled();
+      const std::int64_t start  = measure ? Clock::nowNSec() : 0;
+      const std::size_t written = _writer->appended();
+      const std::size_t dropped = _writer->dropped();
+      const bool ok             = _writer->write(_logs) && _writer->flush();
+      _last_flush               = Clock::nowNSec();
+      _dropped.fetch_add(_writer->dropped() - dropped, std::memory_order_relaxed);
+      ThreadStats* stats = measure ? StatsRegistry::local() : nullptr;
+      if(stats)
+      {
+         stats->flush.add(static_cast<std::uint64_t>(_last_flush - start));
+         stats->bytes_written.add(_writer->appended() - written);
+      }
+      if(ok)
+      {
+         _write_failed = false;
+         this->rotateIfDue();
+         return;
+      }
+      if(!_write_failed)
+      {
+         _os << "Log file could not be written: " << _writer->lastError()
+             << std::endl;
+         _write_failed = true;
+      }
+      if(_logs.bytes() > this->storeLimit())
+      {
+         _dropped.fetch_add(_logs.size(), std::memory_order_relaxed);
+         _logs.clear();
+      }
+   }
+
+   /**
+    * Getter for bytes of stored logs kept before initialize() or while the file
+    * can not be written
+    *
+    * @return 4 * max_bytes of FlushPolicy, 4 MiB if trigger is disabled
+    */
+   std::size_t storeLimit() const
+   {
+      return 4 * (_flush_policy.max_bytes ? _flush_policy.max_bytes : 1 << 20);
+   }
+
+   /**
+    * Creates writer of selected FileMode
+    *
+    * @param[in] file path of log file
+    * @return writer
+    */
+   std::unique_ptr<Writer> createWriter(const std::string& file) const
+   {
+      if(_file_mode == FileMode::MMAP)
+      {
+         return std::unique_ptr<Writer>(new MmapWriter(file));
+      }
+      return std::unique_ptr<Writer>(new Writer(file));
+   }
+
+   /**
+    * Starts new segment "<file>.<n>.log" if a trigger of RotationPolicy fired and
+    * hands the closed one to the archiver, caller has to hold _mutex
+    */
+   void rotateIfDue()
+   {
+      const double elapsed =
+          static_cast<double>(_last_flush - _segment_start) * 1e-9;
+      if(!_archiver || !_rotation.due(_writer->length(), elapsed))
+      {
+         return;
+      }
+      const std::string closed = _writer->getFile();
+      this->closeWriter();
+      _writer = this->createWriter(_file_base + "." + std::to_string(++_segment) +
+                                   ".log");
+      _segment_start = _last_flush;
+      _archiver->archive(closed, _writer->getFile());
+   }
+
+   /**
+    * Closes log file, reports if logs or index could not be written, caller has
+    * to hold _mutex
+    */
+   void closeWriter()
+   {
+      if(_writer && !_writer->close())
+      {
+         _os << "Log file could not be closed: " << _writer->lastError()
+             << std::endl;
+      }
+   }
+
+   /**
+    * Writes stored logs if the interval trigger of FlushPolicy fired and the
+    * Logger is initialized, caller has to hold _mutex
+    */
+   void flushIfIdle()
+   {
+      if(_writer && !_logs.empty() && _flush_policy.max_interval > 0.0 &&
+         static_cast<double>(Clock::nowNSec() - _last_flush) * 1e-9 >=
+             _flush_policy.max_interval)
+      {
+         this->flush();
+      }
+   }
+
+   /**
+    * Enqueues log for consumer thread, async mode only
+    *
+    * @param[in] obj log to enqueue
+    */
+   void enqueue(QueuedLog&& obj)
+   {
+      ThreadStats* stats = StatsRegistry::active();
+      if(!stats)
+      {
+         this->push(std::move(obj));
+         return;
+      }
+      if(stats->isTimed())
+      {
+         const std::int64_t start = Clock::nowNSec();
+         this->push(std::move(obj));
+         stats->enqueue.add(static_cast<std::uint64_t>(Clock::nowNSec() - start));
+      }
+      else
+      {
+         this->push(std::move(obj));
+      }
+      stats->queue_max.raise(this->queueDepth());
+   }
+
+   /**
+    * Pushes log into async queue, waits or drops if it is full
+    *
+    * @param[in] obj log to enqueue
+    */
+   void push(QueuedLog&& obj)
+   {
+      while(!_queue->push(std::move(obj)))
+      {
+         if(!_async_block)
+         {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+         }
+         _async_cv.notify_one();
+         std::this_thread::yield();
+      }
+      _async_pushed.fetch_add(1, std::memory_order_release);
+   }
+
+   /**
+    * Getter for number of logs in async queue
+    *
+    * @return logs enqueued but not stored yet
+    */
+   std::uint64_t queueDepth() const
+   {
+      const std::uint64_t done   = _async_done.load(std::memory_order_acquire);
+      const std::uint64_t pushed = _async_pushed.load(std::memory_order_acquire);
+      return pushed > done ? pushed - done : 0;
+   }
+
+   /**
+    * Consumer thread function, stores and prints enqueued logs in batches until
+    * stopAsync() is called and the queue is empty
+    */
+   void consume()
+   {
+      const std::size_t batch = 256;
+      for(;;)
+      {
+         std::size_t n = 0;
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while(n < batch && _queue->pop([this](QueuedLog& obj) {
+                     if(obj.marker)
+                     {
+                        obj.marker->store(true, std::memory_order_release);
+                        return;
+                     }
+                     this->store(obj.stamp, obj.level, obj.text.data(),
+                                 obj.text.size(), obj.site);
+                  }))
+            {
+               n++;
+            }
+         }
+         if(n)
+         {
+            _async_done.fetch_add(n, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(_async_mutex);
+            _async_cv.notify_all();
+            continue;
+         }
+         if(_async_stop.load(std::memory_order_acquire) && _queue->empty())
+         {
+            return;
+         }
+         if(_dedup_on.load(std::memory_order_acquire))
+         {
+            this->expireRepeats(Clock::nowNSec());
+         }
+         {
+            std::lock_guard<std::mutex> lock(_mutex);
+            this->flushIfIdle();
+         }
+         // producers never notify (would need a lock), so poll with timeout
+         std::unique_lock<std::mutex> lock(_async_mutex);
+         _async_cv.wait_for(lock, std::chrono::milliseconds(1));
+      }
+   }
+
+   /**
+    * Waits until consumer has stored every log enqueued by the calling thread
+    * before this call
+    *
+    * Enqueues a marker behind the logs of the calling thread (the queue keeps the
+    * order of each producer) and waits until the consumer reaches it. The marker
+    * is never dropped, even if the queue does not block producers.
+    */
+   void waitAsync()
+   {
+      std::atomic<bool> reached(false);
+      QueuedLog marker{0, Log::INFO, std::string(), nullptr, &reached};
+      while(!_queue->push(std::move(marker)))
+      {
+         _async_cv.notify_one();
+         std::this_thread::yield();
+      }
+      _async_pushed.fetch_add(1, std::memory_order_release);
+      std::unique_lock<std::mutex> lock(_async_mutex);
+      while(!reached.load(std::memory_order_acquire))
+      {
+         _async_cv.notify_all();
+         _async_cv.wait_for(lock, std::chrono::milliseconds(1));
+      }
+   }
+
+   /**
+    * Stops consumer thread after it has stored all enqueued logs
+    */
+   void stopAsync()
+   {
+      if(!_consumer.joinable())
+      {
+         return;
+      }
+      _async_stop.store(true, std::memory_order_release);
+      {
+         std::lock_guard<std::mutex> lock(_async_mutex);
+         _async_cv.notify_all();
+      }
+      _consumer.join();
+      _async.store(false, std::memory_order_release);
+   }
+
+ public: // functions
+   /**
+    * Getter function for logger name
+    *
+    * @return logger name as std::string
+    */
+   inline std::string getName() const { return _name; }
+
+   /**
+    * Getter function for Logs
+    * @return Logs as LobObj
+    */
+   inline RecordStore& getLogs() { return _logs; }
+
+   /**
+    * Streams value into the log stream of the calling thread, message is logged
+    * when the stream is ended with evo::info, evo::debug, evo::warn or evo::error
+    *
+    * @param[in] value object with overloaded ostream
+    * @return log stream of calling thread
+    */
+   template<typename T>
+   inline LogStream& operator<<(const T& value)
+   {
+      LogStream& stream = LogStream::local();
+      stream << value;
+      return stream;
+   }
+
+   /**
+    * Applies manipulator (e.g. std::hex) to the log stream of the calling thread
+    *
+    * @param[in] manip ostream manipulator
+    * @return log stream of calling thread
+    */
+   inline LogStream& operator<<(std::ostream& (*manip)(std::ostream&))
+   {
+      LogStream& stream = LogStream::local();
+      manip(stream);
+      return stream;
+   }
+
+   /**
+    * Getter for log stream of calling thread, e.g. for functions expecting an
+    * std::ostream
+    *
+    * @return log stream of calling thread
+    */
+   inline LogStream& stream() { return LogStream::local(); }
+
+   /**
+    * @brief Basic log function, used from all wrapper functions
+    *
+    * Basic log function, saves log level and log message and writes log message
+    * to given output stream if given log level is activated for terminal output.
+    * In async mode the record is only enqueued, storing and output is done by the
+    * consumer thread.
+    *
+    * @param[in] level log level of this log
+    * @param[in] text  log message of this log
+    */
+   inline void log(Log::Log level, const std::string& text)
+   {
+      this->log(level, text.data(), text.size());
+   }
+
+   /**
+    * Basic log function for not null terminated messages, see log(level, text)
+    *
+    * @param[in] level log level of this log
+    * @param[in] text  pointer to log message
+    * @param[in] len   length of log message
+    * @param[in] site  call site (see Callsite), may be nullptr
+    */
+   inline void log(Log::Log level, const char* text, const std::size_t len,
+                   Callsite* site = nullptr)
+   {
+      if(site ? !this->isEnabled(*site) : !this->isEnabled(level))
+      {
+         return;
+      }
+      this->submit(level, text, len, site, nullptr);
+   }
+
+   /**
+    * Structured log: message with typed fields
+    *
+    * Terminal, log file and text sinks get the fields appended as logfmt
+    * ("message key=value ..."), JSON and logfmt sinks (see Sink::setFormat()) encode
+    * them as own keys. Nothing is formatted if the level is disabled.
+    *
+    * @code
+    * evo::log::get().log(evo::Log::INFO, "connected", {{"port", 8080}});
+    * @endcode
+    *
+    * @param[in] level  log level of this log
+    * @param[in] msg    log message
+    * @param[in] fields fields, referenced values have to live during the call
+    * @param[in] site   call site (see Callsite), may be nullptr
+    */
+   inline void log(Log::Log level, const char* msg,
+                   std::initializer_list<Field> fields, Callsite* site = nullptr)
+   {
+      if(site ? !this->isEnabled(*site) : !this->isEnabled(level))
+      {
+         return;
+      }
+      this->submitFields(nullptr, level, msg, fields, site);
+   }
+
+   /**
+    * Log function for channels, name of channel is printed in front of message
+    *
+    * @param[in] channel channel of log (see Channel)
+    * @param[in] level   log level of this log
+    * @param[in] text    pointer to log message, not in FormatBuffer::local()
+    * @param[in] len     length of log message
+    * @param[in] site    call site (see Callsite), may be nullptr
+    */
+   inline void log(const Channel& channel, Log::Log level, const char* text,
+                   const std::size_t len, Callsite* site = nullptr)
+   {
+      if(site ? !this->isEnabled(channel, *site) : !this->isEnabled(channel, level))
+      {
+         return;
+      }
+      if(channel.prefix().empty())
+      {
+         this->submit(level, text, len, site, nullptr);
+         return;
+      }
+      FormatBuffer& buf = FormatBuffer::local();
+      buf.clear();
+      buf.append(channel.prefix().data(), channel.prefix().size());
+      buf.append(text, len);
+      this->submit(level, buf.data(), buf.size(), site, nullptr);
+   }
+
+   /**
+    * Structured log for channels, see log(level, msg, fields)
+    *
+    * @param[in] channel channel of log (see Channel)
+    * @param[in] level   log level of this log
+    * @param[in] msg     log message
+    * @param[in] fields  fields, referenced values have to live during the call
+    * @param[in] site    call site (see Callsite), may be nullptr
+    */
+   inline void log(const Channel& channel, Log::Log level, const char* msg,
+                   std::initializer_list<Field> fields, Callsite* site = nullptr)
+   {
+      if(site ? !this->isEnabled(channel, *site) : !this->isEnabled(channel, level))
+      {
+         return;
+      }
+      this->submitFields(&channel, level, msg, fields, site);
+   }
+
+   /**
+    * Forces logger to write all logs stored in _logs in given file (appends file)
+    *
+    * In async mode all records enqueued before this call are written, too. Waits
+    * until buffered terminal output and logs enqueued for sinks are written.
+    * Suppressed calls of rate limited call sites and pending runs of repeated
+    * messages are reported first.
+    */
+   inline void writeLog()
+   {
+      this->flushSuppressed();
+      this->flushRepeats();
+      if(_async.load(std::memory_order_acquire))
+      {
+         this->waitAsync();
+      }
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         this->flush();
+         if(_binary)
+         {
+            _binary->write();
+         }
+      }
+      _console.flush();
+      const auto sinks = std::atomic_load(&_sinks);
+      if(sinks)
+      {
+         for(const std::shared_ptr<Sink>& sink : *sinks)
+         {
+            sink->sync();
+         }
+      }
+   }
+
+   /**
+    * Adds an output with its own level mask and queue, see Sink
+    *
+    * Every log accepted by at least one sink is formatted once and shared by all
+    * sinks accepting its level. Built-in terminal output and log file are not
+    * affected.
+    *
+    * @param[in] sink output, thread is started
+    */
+   inline void addSink(const std::shared_ptr<Sink>& sink)
+   {
+      {
+         std::lock_guard<std::mutex> lock(_sink_mutex);
+         const auto old = std::atomic_load(&_sinks);
+         std::shared_ptr<std::vector<std::shared_ptr<Sink>>> sinks =
+             old ? std::make_shared<std::vector<std::shared_ptr<Sink>>>(*old)
+                 : std::make_shared<std::vector<std::shared_ptr<Sink>>>();
+         sinks->push_back(sink);
+         std::atomic_store(&_sinks,
+                           std::shared_ptr<const std::vector<std::shared_ptr<Sink>>>(
+                               std::move(sinks)));
+      }
+      sink->start([this] { this->updateSinkLevel(); });
+      this->updateSinkLevel();
+   }
+
+   /**
+    * Removes output added with addSink(), waits until no logging thread passes
+    * logs to it anymore, writes its enqueued logs and stops its thread
+    *
+    * @param[in] sink output
+    */
+   inline void removeSink(const std::shared_ptr<Sink>& sink)
+   {
+      std::shared_ptr<const std::vector<std::shared_ptr<Sink>>> old;
+      {
+         std::lock_guard<std::mutex> lock(_sink_mutex);
+         old = std::atomic_load(&_sinks);
+         if(!old)
+         {
+            return;
+         }
+         std::shared_ptr<std::vector<std::shared_ptr<Sink>>> sinks =
+             std::make_shared<std::vector<std::shared_ptr<Sink>>>();
+         for(const std::shared_ptr<Sink>& s : *old)
+         {
+            if(s != sink)
+            {
+               sinks->push_back(s);
+            }
+         }
+         std::atomic_store(&_sinks,
+                           std::shared_ptr<const std::vector<std::shared_ptr<Sink>>>(
+                               std::move(sinks)));
+      }
+      // producers in dispatch() hold the old list while pushing, wait for them so
+      // no log is pushed into the sink after stop()
+      while(old.use_count() > 1)
+      {
+         std::this_thread::yield();
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      this->updateSinkLevel();
+      sink->stop();
+   }
+
+   /**
+    * Enables binary mode, has only on first call an effect
+    *
+    * All logs are stored in "<log file>.blog" instead of the .log file. Printf-style
+    * logs of the EVO_* macros are stored unformatted (their format string literal
+    * is identified by address) and only formatted if they are printed to terminal,
+    * all other logs are stored as formatted text. Use
+    * evo_log_decoder to convert the file to text. Binary logs bypass the async
+    * queue, the encoding is short enough to be done by the logging thread.
+    */
+   inline void enableBinary()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_binary)
+      {
+         return;
+      }
+      if(!_writer)
+      {
+         this->initialize("EVO");
+      }
+      _binary = std::unique_ptr<BinaryLog>(
+          new BinaryLog(_file_base + ".blog", _flush_policy));
+      _binary_on.store(true, std::memory_order_release);
+   }
+
+   /**
+    * Enables deduplication, has only on first call an effect
+    *
+    * A message equal to the last message of its level and call site (compared by
+    * hash and length) is dropped and counted. The run of repeats is logged as one
+    * message "last message repeated N times (first <time>, last <time>): <first
+    * bytes>" when a different message of that call site arrives, with the next
+    * log of any call site once the run is older than max_interval seconds (in
+    * async mode also by the consumer thread when idle) and on writeLog(), see
+    * Deduplicator. Printf-style logs stored by binary mode are not deduplicated.
+    *
+    * @param[in] max_interval [s] a run of repeats is reported at least this often
+    */
+   inline void enableDedup(const double max_interval = 1.0)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_dedup)
+      {
+         return;
+      }
+      _dedup = std::unique_ptr<Deduplicator>(new Deduplicator(max_interval));
+      _dedup_on.store(true, std::memory_order_release);
+   }
+
+   /**
+    * Getter for deduplication
+    *
+    * @return true if deduplication is enabled
+    */
+   inline bool isDedup() const { return _dedup_on.load(std::memory_order_acquire); }
+
+   /**
+    * Enables flight recorder, has only on first call an effect
+    *
+    * Every log is also copied into a ring of given size in the memory mapped file
+    * "<log file>.ring", so the latest logs survive a crash of the process (see
+    * FlightRecorder). The file is removed on clean shutdown, extract logs from a
+    * leftover file with evo_log_recover.
+    *
+    * @param[in] size bytes of ring
+    * @return false if ring file could not be created
+    */
+   inline bool enableFlightRecorder(const std::size_t size = 8 << 20)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_flight)
+      {
+         return true;
+      }
+      if(!_writer)
+      {
+         this->initialize("EVO");
+      }
+      std::unique_ptr<FlightRecorder> flight(
+          new FlightRecorder(_file_base + ".ring", size));
+      if(!flight->isOpen())
+      {
+         _os << "Flight recorder could not be enabled: " << flight->lastError()
+             << std::endl;
+         return false;
+      }
+      _flight = std::move(flight);
+      _flight_on.store(true, std::memory_order_release);
+      return true;
+   }
+
+   /**
+    * Copies message into ring of flight recorder and to sinks only, if enabled
+    * (used for binary mode, where the message is not passed to log())
+    *
+    * @param[in] level log level of message
+    * @param[in] text  pointer to message
+    * @param[in] len   length of message
+    */
+   inline void record(Log::Log level, const char* text, const std::size_t len)
+   {
+      const std::int64_t ns = Clock::nowNSec();
+      if(_flight_on.load(std::memory_order_acquire))
+      {
+         _flight->append(ns, level, text, len);
+      }
+      this->dispatch(ns, level, text, len);
+   }
+
+   /**
+    * Getter for flight recorder
+    *
+    * @return true if flight recorder is enabled
+    */
+   inline bool isFlightRecorder() const
+   {
+      return _flight_on.load(std::memory_order_acquire);
+   }
+
+   /**
+    * Getter for binary mode
+    *
+    * @return true if binary mode is enabled
+    */
+   inline bool isBinary() const { return _binary_on.load(std::memory_order_acquire); }
+
+   /**
+    * Stores printf-style log of call site unformatted in binary log, binary mode
+    * only
+    *
+    * @param[in] site call site of an EVO_* macro, its format string literal and
+    * log level are used
+    * @param[in] args printf args
+    */
+   template<typename... Args>
+   inline void logBinary(const Callsite& site, Args... args)
+   {
+      if(Callsite::forced(&site) || this->isStored(site.level()))
+      {
+         _binary->append(site.level(), site.format(), args...);
+      }
+   }
+
+   /**
+    * Proves if logs of given level are printed or stored, used by the level macros
+    * to skip argument evaluation. A single relaxed atomic load of the union of all
+    * level masks, checked before timestamping, formatting and locking.
+    *
+    * @param[in] level log level
+    * @return true if enabled for terminal, file or a sink
+    */
+   inline bool isEnabled(Log::Log level) const
+   {
+      return static_cast<LogType>(level) &
+             _enabled_log_level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Proves if any sink accepts given log level
+    *
+    * @param[in] level log level
+    * @return true if accepted
+    */
+   inline bool isDispatched(Log::Log level) const
+   {
+      return static_cast<LogType>(level) &
+             _sink_log_level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Proves if logs of given call site are printed or stored: a call site switched
+    * on or off with Callsite::enable()/disable() overrides the log levels
+    *
+    * @param[in] site call site, registered on first call
+    * @return true if enabled
+    */
+   inline bool isEnabled(Callsite& site) const
+   {
+      switch(site.state())
+      {
+         case CallsiteState::ON: return true;
+         case CallsiteState::OFF: return false;
+         default: return this->isEnabled(site.level());
+      }
+   }
+
+   /**
+    * Proves if logs of given level and channel are printed or stored
+    *
+    * @param[in] channel channel, its level mask is checked first
+    * @param[in] level   log level
+    * @return true if enabled for channel and terminal, file or a sink
+    */
+   inline bool isEnabled(const Channel& channel, Log::Log level) const
+   {
+      return channel.isEnabled(level) && this->isEnabled(level);
+   }
+
+   /**
+    * Proves if logs of given call site and channel are printed or stored, see
+    * isEnabled(site)
+    *
+    * @param[in] channel channel, its level mask is checked first
+    * @param[in] site    call site, registered on first call
+    * @return true if enabled
+    */
+   inline bool isEnabled(const Channel& channel, Callsite& site) const
+   {
+      switch(site.state())
+      {
+         case CallsiteState::ON: return true;
+         case CallsiteState::OFF: return false;
+         default: return this->isEnabled(channel, site.level());
+      }
+   }
+
+   /**
+    * Proves if given log level is stored for file
+    *
+    * @param[in] level log level
+    * @return true if enabled
+    */
+   inline bool isStored(Log::Log level) const
+   {
+      return static_cast<LogType>(level) &
+             _file_log_level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Proves if given log level is enabled for terminal output
+    *
+    * @param[in] level log level
+    * @return true if enabled
+    */
+   inline bool isPrinted(Log::Log level) const
+   {
+      return static_cast<LogType>(level) &
+             _current_log_level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Writes message to terminal only (not stored for file), if level is enabled
+    * for terminal output or call site is switched on
+    *
+    * @param[in] level log level of message
+    * @param[in] text  pointer to message
+    * @param[in] len   length of message
+    * @param[in] site  call site (see Callsite), may be nullptr
+    */
+   inline void print(Log::Log level, const char* text, const std::size_t len,
+                     const Callsite* site = nullptr)
+   {
+      if(!Callsite::forced(site) && !this->isPrinted(level))
+      {
+         return;
+      }
+      _console.write(level, Clock::nowNSec(), text, len, Callsite::location(site));
+   }
+
+   /**
+    * Enables or disables printing of call site location "file:line" in front of
+    * messages logged with the EVO_* macros, for terminal, log file and sinks
+    *
+    * @param[in] enable true to print location
+    */
+   inline void setLocation(const bool enable) { Callsite::setLocation(enable); }
+
+   /**
+    * Setter for log rotation, a new file segment is started when a trigger fires,
+    * closed segments are compressed and old files deleted in background (see
+    * RotationPolicy)
+    *
+    * @note if called before initialize(), the log file is named after "EVO"
+    *
+    * @param[in] policy rotation triggers and retention limits
     */
-   Logger& operator=(const Logger&) = delete;
+   inline void setRotationPolicy(const RotationPolicy& policy)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(!_writer)
+      {
+         this->initialize("EVO");
+      }
+      _rotation = policy;
+      if(!_archiver && policy.enabled())
+      {
+         _archiver = std::unique_ptr<LogArchiver>(
+             new LogArchiver(_log_folder, _name, [this](const std::string& error) {
+                const std::string msg = "Log archiver: " + error;
+                this->print(Log::WARN, msg.data(), msg.size());
+             }));
+      }
+      if(_archiver)
+      {
+         _archiver->setPolicy(policy);
+      }
+   }
 
    /**
-    * =operator(move) deleted -> Singleton
+    * Getter for log rotation
+    *
+    * @return rotation triggers and retention limits
     */
-   Logger& operator=(Logger&&) = delete;
+   inline RotationPolicy getRotationPolicy()
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _rotation;
+   }
 
    /**
-    * Singleton pattern
+    * Setter for terminal output behaviour
     *
-    * @return Instance from Logger
+    * @param[in] colors colored output, default is enabled if stdout is a terminal
+    * @param[in] block  if true logging waits for a slow terminal, else (default)
+    * logs are dropped and the number of dropped logs is printed
     */
-   static inline Logger& instance()
+   inline void setConsole(const bool colors, const bool block = false)
    {
-      static Logger instance;
-      return instance;
+      _console.setColorsEnabled(colors);
+      _console.setBlocking(block);
    }
 
    /**
-    * Initialize Logger, has only on first call an effect
+    * Getter for number of logs not printed because the terminal was too slow
     *
-    * @param[in] name name of program or user defined name
+    * @return dropped logs
     */
-   void initialize(const std::string& name)
+   inline std::uint64_t getConsoleDroppedCount() const
    {
-      // set only once
-      if(_writer)
-      {
-         return;
-      }
-
-      _name = name;
-
-      std::string log_folder = Utility::getHomeDir() + "/" + LOG_FOLDER + "/";
+      return _console.getDroppedCount();
+   }
 
-      // prove folder exists
-      if(!Utility::directoryExists(log_folder))
+   /**
+    * Setter for triggers which write stored logs to file
+    *
+    * @note triggers fire after initialize() only, logs before are kept in memory
+    * so the log file gets the name and FileMode passed to initialize()
+    *
+    * @param[in] policy flush triggers
+    */
+   inline void setFlushPolicy(const FlushPolicy& policy)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _flush_policy = policy;
+      if(_binary)
       {
-         // create log folder
-         // linux
-         if(mkdir(log_folder.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) != 0 ||
-            (!Utility::directoryExists(log_folder)))
-         {
-            _os << "LOG_FOLDER could not be set.... take current Direktory"
-                << std::endl;
-            log_folder = "";
-         }
+         _binary->setFlushPolicy(policy);
       }
-
-      // get name for logfile:
-      std::string log_file(evo::Time::toString(evo::Time::now()) + std::string("-") +
-                           _name + std::string(".log"));
-
-      _writer = std::unique_ptr<Writer>(new Writer(log_folder + log_file));
    }
 
- private:
    /**
-    * Default private Constructor -> Singleton
+    * Getter for triggers which write stored logs to file
+    *
+    * @return flush triggers
     */
-   Logger() :
-       _os(std::cout), _color_def_f(OSColor(Color::F_DEFAULT)),
-       _color_def_b(OSColor(Color::B_DEFAULT)),
-       _color_info_f(OSColor(Color::F_DEFAULT)),
-       _color_info_b(OSColor(Color::B_DEFAULT)),
-       _color_debug_f(OSColor(Color::F_LIGHT_BLUE)),
-       _color_debug_b(OSColor(Color::B_DEFAULT)),
-       _color_warn_f(OSColor(Color::F_LIGHT_RED)),
-       _color_warn_b(OSColor(Color::B_DEFAULT)),
-       _color_error_f(OSColor(Color::F_DEFAULT)),
-       _color_error_b(OSColor(Color::B_RED))
+   inline FlushPolicy getFlushPolicy()
    {
-      _current_log_level = static_cast<LogType>(Log::ALL);
+      std::lock_guard<std::mutex> lock(_mutex);
+      return _flush_policy;
    }
 
    /**
-    * Destructor writes Logs to file
+    * Enables asynchronous mode, has only on first call an effect
+    *
+    * Logging threads enqueue their records into a bounded lock-free queue and
+    * return, a background thread does terminal output and stores the records for
+    * the file. Mode stays active until the Logger is destroyed.
+    *
+    * @param[in] capacity number of records the queue can hold (power of two)
+    * @param[in] block_if_full if true producers yield until the queue has space,
+    * else records are dropped and counted (see getDroppedCount())
     */
-   ~Logger()
+   inline void enableAsync(const std::size_t capacity = 8192,
+                           const bool block_if_full = true)
    {
-      if(!_writer)
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_queue)
       {
-         this->initialize("EVO");
+         return;
       }
-      _writer->write(_logs);
+      _async_block = block_if_full;
+      _queue       = std::unique_ptr<MpscQueue<QueuedLog>>(
+          new MpscQueue<QueuedLog>(capacity));
+      _consumer = std::thread(&Logger::consume, this);
+      _async.store(true, std::memory_order_release);
    }
 
    /**
-    * forces ERROR output, even if it is disabled
+    * Getter for async mode
     *
-    * @todo check if needed
+    * @return true if async mode is enabled
     */
-   void forceOutput() { _current_log_level |= static_cast<LogType>(Log::ERROR); }
-
-   std::vector<LogObj> _logs; ///< Container for logs
-
-   LogType _current_log_level; ///< current Log level
-
-   std::string _name; ///< name of Logger
-
-   std::unique_ptr<Writer> _writer; ///< Writer Object
-
-   std::ostream& _os; ///< ostream
-
-   std::mutex _mutex; ///< mutex for thread safety (c++11)
-
-   OSColor _color_def_f;   ///< default color foreground
-   OSColor _color_def_b;   ///< default color background
-   OSColor _color_info_f;  ///< info color foreground
-   OSColor _color_info_b;  ///< info color background
-   OSColor _color_debug_f; ///< debug color foreground
-   OSColor _color_debug_b; ///< debug color background
-   OSColor _color_warn_f;  ///< warn color foreground
-   OSColor _color_warn_b;  ///< warn color background
-   OSColor _color_error_f; ///< error color foreground
-   OSColor _color_error_b; ///< error color background
+   inline bool isAsync() const { return _async.load(std::memory_order_relaxed); }
 
- public: // functions
    /**
-    * Getter function for logger name
+    * Getter for number of records dropped because the async queue was full or no
+    * memory was left
     *
-    * @return logger name as std::string
+    * @return number of dropped records
     */
-   inline std::string getName() const { return _name; }
+   inline std::uint64_t getDroppedCount() const
+   {
+      return _dropped.load(std::memory_order_relaxed);
+   }
 
    /**
-    * Getter function for Logs
-    * @return Logs as LobObj
+    * Enables self-instrumentation of the Logger (see LogStats)
+    *
+    * Every thread counts its logs per level, bytes and suppressed logs and
+    * measures the time spent in the Logger per log, waiting for and holding the
+    * mutex, enqueueing in async mode and writing the log file. Values are totals
+    * since the first call, read them with getStats(). While disabled, the cost is
+    * one relaxed load per log, while enabled every log is counted and latencies
+    * are measured for every ThreadStats::SAMPLE-th log of each thread.
+    *
+    * @note logs of binary mode (logBinary()) are not counted
+    *
+    * @param[in] summary_interval if > 0, a summary of the statistics is logged at
+    * INFO level with the first log after each interval [s]
     */
-   inline std::vector<LogObj>& getLogs() { return _logs; }
+   inline void enableStats(const double summary_interval = 0.0)
+   {
+      const std::int64_t now = Clock::nowNSec();
+      std::int64_t unset     = 0;
+      _stats_start.compare_exchange_strong(unset, now, std::memory_order_relaxed);
+      const std::int64_t interval =
+          static_cast<std::int64_t>(summary_interval * 1e9);
+      _stats_interval.store(interval > 0 ? interval : 0, std::memory_order_relaxed);
+      _stats_next.store(now + interval, std::memory_order_relaxed);
+      StatsRegistry::setEnabled(true);
+   }
 
    /**
-    * @brief Basic log function, used from all wrapper functions
-    *
-    * Basic log function, saves log level and log message and writes log message
-    * to given output stream if given log level is activated for terminal output
-    *
-    * @param[in] level log level of this log
-    * @param[in] text  log message of this log
+    * Stops self-instrumentation, collected values are kept
     */
-   inline void log(Log::Log level, const std::string& text)
+   inline void disableStats()
    {
-      _mutex.lock();
-      // save log
-      LogObj obj = {evo::Time::now(), level, text};
-      try
-      {
-         _logs.push_back(std::move(obj));
-      } catch(std::bad_alloc& e)
-      {
-         _os << "Bad alloc in _logs.push_back... will delete all logs to prevent "
-                "more damage"
-             << std::endl;
-         exit(0);
-         _logs.clear();
-      }
-      // prove output
-      if(static_cast<LogType>(level) & _current_log_level) // binary and
-      {
-         _os << LogObj::parse(obj) << _color_def_b << _color_def_f
-             << std::endl; // set default color
-      }
-      else
-      {
-         _os << _color_def_b << _color_def_f; // to prevent bug where disabled log
-                                              // level color terminal
-      }
-      _mutex.unlock();
+      StatsRegistry::setEnabled(false);
+      _stats_interval.store(0, std::memory_order_relaxed);
    }
 
    /**
-    * Forces logger to write all logs stored in _logs in given file (appends file)
+    * Getter for self-instrumentation
+    *
+    * @return true if statistics are collected
     */
-   inline void writeLog()
+   inline bool isStats() const { return StatsRegistry::enabled(); }
+
+   /**
+    * Getter for snapshot of self-instrumentation, see enableStats()
+    *
+    * Drop counters and the async queue depth are included even if statistics
+    * were never enabled.
+    *
+    * @return statistics of all threads
+    */
+   inline LogStats getStats()
    {
-      _mutex.lock();
-      if(!_writer)
+      LogStats stats;
+      StatsRegistry::collect(stats);
+      const std::int64_t start = _stats_start.load(std::memory_order_relaxed);
+      stats.elapsed =
+          start ? static_cast<double>(Clock::nowNSec() - start) * 1e-9 : 0.0;
+      stats.dropped          = this->getDroppedCount();
+      stats.console_dropped  = _console.getDroppedCount();
+      stats.console_stalls   = _console.getStallCount();
+      stats.console_stall_ns = _console.getStallNs();
+      const auto sinks       = std::atomic_load(&_sinks);
+      if(sinks)
       {
-         this->initialize("EVO");
+         for(const std::shared_ptr<Sink>& sink : *sinks)
+         {
+            stats.sink_dropped += sink->getDroppedCount();
+         }
       }
-      _writer->write(_logs);
-      _mutex.unlock();
+      stats.queue_depth = this->isAsync() ? this->queueDepth() : 0;
+      stats.queue_max   = std::max(stats.queue_max, stats.queue_depth);
+      return stats;
    }
 
    /**
@@ -285,48 +1763,32 @@ class Logger : public std::basic_stringstream<char>
     *
     * @param[in] text log message
     */
-   inline void info(const std::string& text)
-   {
-      _os << _color_info_f << _color_info_b;
-      this->log(Log::INFO, text);
-   }
+   inline void info(const std::string& text) { this->log(Log::INFO, text); }
 
    /**
     * function for log at debug level, std::string only
     *
     * @param[in] text log message
     */
-   inline void debug(const std::string& text)
-   {
-      _os << _color_debug_f << _color_debug_b;
-      this->log(Log::DEBUG, text);
-   }
+   inline void debug(const std::string& text) { this->log(Log::DEBUG, text); }
 
    /**
     * function for log at warn level, std::string only
     *
     * @param[in] text log message
     */
-   inline void warn(const std::string& text)
-   {
-      _os << _color_warn_f << _color_warn_b;
-      this->log(Log::WARN, text);
-   }
+   inline void warn(const std::string& text) { this->log(Log::WARN, text); }
 
    /**
     * function for log at error level, std::string only
     *
     * @param[in] text log message
     */
-   inline void error(const std::string& text)
-   {
-      _os << _color_error_f << _color_error_b;
-      this->log(Log::ERROR, text);
-   }
+   inline void error(const std::string& text) { this->log(Log::ERROR, text); }
 
    /**
-    * function for setting log level, only for terminal output, all logs will be
-    * written to file
+    * function for setting log level, only for terminal output, see
+    * setFileLogLevel() for file
     *
     * @note log level ERROR can not be disabled (will be force activated)
     *
@@ -341,8 +1803,9 @@ class Logger : public std::basic_stringstream<char>
     */
    inline void setLogLevel(const LogType level)
    {
-      _current_log_level = static_cast<LogType>(level);
+      _current_log_level.store(level, std::memory_order_relaxed);
       this->forceOutput();
+      this->updateEnabledLevel();
    }
 
    /**
@@ -352,8 +1815,9 @@ class Logger : public std::basic_stringstream<char>
     */
    inline void appendLogLevel(const LogType level)
    {
-      _current_log_level |= static_cast<LogType>(level);
+      _current_log_level.fetch_or(level, std::memory_order_relaxed);
       this->forceOutput();
+      this->updateEnabledLevel();
    }
 
    /**
@@ -366,8 +1830,47 @@ class Logger : public std::basic_stringstream<char>
     */
    inline void removeLogLevel(const LogType level)
    {
-      _current_log_level &= ~(static_cast<LogType>(level));
+      _current_log_level.fetch_and(~level, std::memory_order_relaxed);
       this->forceOutput();
+      this->updateEnabledLevel();
+   }
+
+   /**
+    * Getter for log level of terminal output
+    *
+    * @return level mask
+    */
+   inline LogType getLogLevel() const
+   {
+      return _current_log_level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * function for setting log level stored for file, logs of other levels are
+    * only printed (if enabled for terminal output) or dropped
+    *
+    * Following code shows usage:
+    * @code
+    * evo::log::get().setFileLogLevel(evo::Log::INFO | evo::Log::WARN | evo::Log::ERROR);
+    * @endcode
+    *
+    * @param[in] level as Log-enum (e.G. Log::INFO), more levels can be appendend
+    * with |-operator
+    */
+   inline void setFileLogLevel(const LogType level)
+   {
+      _file_log_level.store(level, std::memory_order_relaxed);
+      this->updateEnabledLevel();
+   }
+
+   /**
+    * Getter for log level stored for file
+    *
+    * @return level mask
+    */
+   inline LogType getFileLogLevel() const
+   {
+      return _file_log_level.load(std::memory_order_relaxed);
    }
 };
 
@@ -389,10 +1892,12 @@ class log
    /**
     * Wraps Logger::initialize(..)
     * @param[in] name logger name
+    * @param[in] mode writer for log file
     */
-   static inline void init(const std::string& name)
+   static inline void init(const std::string& name,
+                           const FileMode::FileMode mode = FileMode::STREAM)
    {
-      Logger::instance().initialize(name);
+      Logger::instance().initialize(name, mode);
    }
 
    /**
@@ -407,6 +1912,16 @@ class log
     */
    static inline Logger& get() { return Logger::instance(); }
 
+   /**
+    * Wraps Channel::get()
+    * @param[in] name dot separated channel name, e.g. "driver.lidar"
+    * @return channel, valid until the end of the program
+    */
+   static inline Channel& channel(const std::string& name)
+   {
+      return Channel::get(name);
+   }
+
    /**
     * Wraps Logger::info(..)
     * @param[in] text log message as std::string
@@ -420,7 +1935,10 @@ class log
     * Wraps Logger::info(..)
     * @param str log message as const char* (C-String)
     */
-   static inline void info(const char* str) { Logger::instance().info(str); }
+   static inline void info(const char* str)
+   {
+      Logger::instance().log(Log::INFO, str, std::strlen(str));
+   }
 
    /**
     * Delegates printf-syntax as std::string to Logger::info(..)
@@ -430,7 +1948,17 @@ class log
    template<typename... Args>
    static inline void info(const char* cstr, Args... args)
    {
-      Logger::instance().info(log::printfToString(cstr, args...));
+      log::printfLog(nullptr, nullptr, Log::INFO, cstr, args...);
+   }
+
+   /**
+    * Wraps Logger::log(..) for structured logs
+    * @param[in] msg    log message
+    * @param[in] fields typed key/value pairs (see Field)
+    */
+   static inline void info(const char* msg, std::initializer_list<Field> fields)
+   {
+      Logger::instance().log(Log::INFO, msg, fields);
    }
 
    /**
@@ -446,7 +1974,10 @@ class log
     * Wraps Logger::debug(..)
     * @param[in] text log message as const char* (C-String)
     */
-   static inline void debug(const char* str) { Logger::instance().debug(str); }
+   static inline void debug(const char* str)
+   {
+      Logger::instance().log(Log::DEBUG, str, std::strlen(str));
+   }
 
    /**
     * Delegates printf-syntax as std::string to Logger::debug(..)
@@ -456,7 +1987,17 @@ class log
    template<typename... Args>
    static inline void debug(const char* cstr, Args... args)
    {
-      Logger::instance().debug(log::printfToString(cstr, args...));
+      log::printfLog(nullptr, nullptr, Log::DEBUG, cstr, args...);
+   }
+
+   /**
+    * Wraps Logger::log(..) for structured logs
+    * @param[in] msg    log message
+    * @param[in] fields typed key/value pairs (see Field)
+    */
+   static inline void debug(const char* msg, std::initializer_list<Field> fields)
+   {
+      Logger::instance().log(Log::DEBUG, msg, fields);
    }
 
    /**
@@ -472,7 +2013,10 @@ class log
     * Wraps Logger::warn(..)
     * @param[in] text log message as const char* (C-String)
     */
-   static inline void warn(const char* str) { Logger::instance().warn(str); }
+   static inline void warn(const char* str)
+   {
+      Logger::instance().log(Log::WARN, str, std::strlen(str));
+   }
 
    /**
     * Delegates printf-syntax as std::string to Logger::warn(..)
@@ -482,7 +2026,17 @@ class log
    template<typename... Args>
    static inline void warn(const char* cstr, Args... args)
    {
-      Logger::instance().warn(log::printfToString(cstr, args...));
+      log::printfLog(nullptr, nullptr, Log::WARN, cstr, args...);
+   }
+
+   /**
+    * Wraps Logger::log(..) for structured logs
+    * @param[in] msg    log message
+    * @param[in] fields typed key/value pairs (see Field)
+    */
+   static inline void warn(const char* msg, std::initializer_list<Field> fields)
+   {
+      Logger::instance().log(Log::WARN, msg, fields);
    }
 
    /**
@@ -498,7 +2052,10 @@ class log
     * Wraps Logger::error(..)
     * @param[in] text log message as const char* (C-String)
     */
-   static inline void error(const char* str) { Logger::instance().error(str); }
+   static inline void error(const char* str)
+   {
+      Logger::instance().log(Log::ERROR, str, std::strlen(str));
+   }
 
    /**
     * Delegates printf-syntax as std::string to Logger::error(..)
@@ -508,10 +2065,115 @@ class log
    template<typename... Args>
    static inline void error(const char* cstr, Args... args)
    {
-      Logger::instance().error(log::printfToString(cstr, args...));
+      log::printfLog(nullptr, nullptr, Log::ERROR, cstr, args...);
+   }
+
+   /**
+    * Wraps Logger::log(..) for structured logs
+    * @param[in] msg    log message
+    * @param[in] fields typed key/value pairs (see Field)
+    */
+   static inline void error(const char* msg, std::initializer_list<Field> fields)
+   {
+      Logger::instance().log(Log::ERROR, msg, fields);
+   }
+
+   /**
+    * Logs message of call site, used by the EVO_* macros
+    * @param[in] site call site with log level
+    * @param[in] str  log message as const char* (C-String)
+    */
+   static inline void at(Callsite& site, const char* str)
+   {
+      Logger::instance().log(site.level(), str, std::strlen(str), &site);
+   }
+
+   /**
+    * Logs printf-style message of call site, used by the EVO_* macros
+    * @param[in] site call site with log level
+    * @param[in] cstr printf str
+    * @param[in] args printf args
+    */
+   template<typename... Args>
+   static inline void at(Callsite& site, const char* cstr, Args... args)
+   {
+      log::printfLog(nullptr, &site, site.level(), cstr, args...);
+   }
+
+   /**
+    * Logs message of call site in channel, used by the EVO_CH_* macros
+    * @param[in] channel channel of log
+    * @param[in] site    call site with log level
+    * @param[in] str     log message as const char* (C-String)
+    */
+   static inline void at(const Channel& channel, Callsite& site, const char* str)
+   {
+      Logger::instance().log(channel, site.level(), str, std::strlen(str), &site);
+   }
+
+   /**
+    * Logs printf-style message of call site in channel, used by the EVO_CH_*
+    * macros
+    * @param[in] channel channel of log
+    * @param[in] site    call site with log level
+    * @param[in] cstr    printf str
+    * @param[in] args    printf args
+    */
+   template<typename... Args>
+   static inline void at(const Channel& channel, Callsite& site, const char* cstr,
+                         Args... args)
+   {
+      log::printfLog(&channel, &site, site.level(), cstr, args...);
    }
 
  private:
+   /**
+    * Logs printf-style message, stores it unformatted in binary mode if it comes
+    * from a call site of the EVO_* macros (format string is a checked literal),
+    * except for channels, their name is formatted in front of the message
+    *
+    * @param[in] channel channel, may be nullptr
+    * @param[in] site    call site, may be nullptr
+    * @param[in] level   log level
+    * @param[in] cstr    printf str
+    * @param[in] args    printf args
+    */
+   template<typename... Args>
+   static inline void printfLog(const Channel* channel, Callsite* site,
+                                Log::Log level, const char* cstr, Args... args)
+   {
+      Logger& logger = Logger::instance();
+      if(site ? !logger.isEnabled(*site) : !logger.isEnabled(level))
+      {
+         return; // nothing is formatted for disabled levels
+      }
+      const bool prefixed = channel && !channel->prefix().empty();
+      const bool binary   = site && logger.isBinary() && !prefixed;
+      if(binary)
+      {
+         logger.logBinary(*site, args...);
+         if(!logger.isPrinted(level) && !Callsite::forced(site) &&
+            !logger.isFlightRecorder() && !logger.isDispatched(level))
+         {
+            return;
+         }
+      }
+      FormatBuffer& buf = FormatBuffer::local();
+      buf.clear();
+      if(prefixed)
+      {
+         buf.append(channel->prefix().data(), channel->prefix().size());
+      }
+      Format::format(buf, cstr, args...);
+      if(binary)
+      {
+         logger.record(level, buf.data(), buf.size());
+         logger.print(level, buf.data(), buf.size(), site);
+         return;
+      }
+      logger.log(level, buf.data(), buf.size(), site);
+   }
+
    /**
     * Converts a Printf-Syntax to std::string
     * @param[in] str  printf-style string (%f,%d,...)
@@ -521,11 +2183,7 @@ class log
    template<typename... Args>
    static inline std::string printfToString(const char* str, Args... args)
    {
-      std::size_t size = snprintf(nullptr, 0, str, args...) + 1; // +1 for '\0'
-      std::unique_ptr<char[]> buffer(new char[size]);
-      snprintf(buffer.get(), size, str, args...);
-
-      return std::string(buffer.get(), buffer.get() + size - 1); // without '\0'
+      return Format::toString(str, args...);
    }
 };
 
@@ -538,15 +2196,10 @@ class Info
  public:
    friend std::ostream& operator<<(std::ostream& os, const evo::Info& rhs)
    {
-      // in case it is not used with Logger instance
-      std::string str = log::get().str();
-      //    if( str.empty() )
-      //      return os;
-
-      log::info(str);
-      // clear sstream
-      log::instance().str("");
-      log::instance().clear();
+      // message was streamed into log stream of this thread
+      LogStream& stream = LogStream::local();
+      log::get().log(Log::INFO, stream.data(), stream.size());
+      stream.reset();
       return os;
    }
 };
@@ -559,15 +2212,10 @@ class Debug
 {
    friend std::ostream& operator<<(std::ostream& os, const evo::Debug& rhs)
    {
-      // in case it is not used with Logger instance
-      std::string str = log::get().str();
-      //    if( str.empty() )
-      //      return os;
-
-      log::debug(str);
-      // clear sstream
-      log::instance().str("");
-      log::instance().clear();
+      // message was streamed into log stream of this thread
+      LogStream& stream = LogStream::local();
+      log::get().log(Log::DEBUG, stream.data(), stream.size());
+      stream.reset();
       return os;
    }
 };
@@ -580,15 +2228,10 @@ class Warn
 {
    friend std::ostream& operator<<(std::ostream& os, const evo::Warn& rhs)
    {
-      // in case it is not used with Logger instance
-      std::string str = log::get().str();
-      //    if( str.empty() )
-      //      return os;
-
-      log::warn(str);
-      // clear sstream
-      log::instance().str("");
-      log::instance().clear();
+      // message was streamed into log stream of this thread
+      LogStream& stream = LogStream::local();
+      log::get().log(Log::WARN, stream.data(), stream.size());
+      stream.reset();
       return os;
    }
 };
@@ -601,15 +2244,10 @@ class Error
 {
    friend std::ostream& operator<<(std::ostream& os, const evo::Error& rhs)
    {
-      // in case it is not used with Logger instance
-      std::string str = log::get().str();
-      //    if( str.empty() )
-      //      return os;
-
-      log::error(str);
-      // clear sstream
-      log::instance().str("");
-      log::instance().clear();
+      // message was streamed into log stream of this thread
+      LogStream& stream = LogStream::local();
+      log::get().log(Log::ERROR, stream.data(), stream.size());
+      stream.reset();
       return os;
    }
 };
@@ -625,4 +2263,7 @@ __attribute__((unused)) static Error error;
 
 } // namespace evo
 
+#include "evo_logger/log/LogMacros.h"
+#include "evo_logger/log/RateLimit.h"
+
 #endif /* LOGGER_H_ */
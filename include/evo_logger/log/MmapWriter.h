@@ -0,0 +1,215 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOMMAPWRITER_H_
+#define EVOMMAPWRITER_H_
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/log/RecordStore.h"
+#include "evo_logger/log/Writer.h"
+
+namespace evo {
+
+/**
+ * @brief Writer formatting logs directly into the memory mapped log file
+ *
+ * The file is grown in extents (default 64 MiB) with fallocate and mapped, logs
+ * are formatted straight into the mapping and written back by the kernel. Only
+ * growing the file needs system calls, flush() only appends the index (see
+ * LogIndex). close() (also called by the destructor) truncates the file to its
+ * real length, after a crash the file ends with the zero filled rest of the last
+ * extent (cut off when a Writer opens the file again).
+ *
+ * Select it with Logger::initialize(name, FileMode::MMAP).
+ *
+ * @author MSC
+ */
+class MmapWriter : public Writer
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] file   for writing logs
+    * @param[in] extent bytes the file is grown and mapped at once
+    */
+   MmapWriter(std::string file, const std::size_t extent = 64 << 20) :
+       Writer(file), _extent(extent)
+   {
+   }
+
+   /**
+    * Destructor closes file, see close()
+    */
+   ~MmapWriter() override { this->close(); }
+
+   /**
+    * Unmaps and truncates file to written length, writes index and closes file
+    *
+    * @return false if file could not be truncated (it keeps a zero filled tail)
+    * or index not be written, see lastError()
+    */
+   bool close() override
+   {
+      this->unmap();
+      bool ok = true;
+      if(_fd >= 0 && ::ftruncate(_fd, static_cast<off_t>(_length)) != 0)
+      {
+         this->setError("truncate");
+         ok = false;
+      }
+      return Writer::close() && ok;
+   }
+
+   /**
+    * Formats given logs into mapped file and deletes them from the store
+    *
+    * @param[in, out] obj containing all logs to write, kept if file can not be
+    * opened
+    * @return false if file could not be opened or grown (remaining logs are
+    * dropped, see dropped()), see lastError()
+    */
+   bool write(RecordStore& obj) override
+   {
+      if(obj.empty())
+      {
+         return true;
+      }
+      if(_fd < 0 && !this->openFile(O_RDWR | O_CREAT | O_CLOEXEC))
+      {
+         return false;
+      }
+
+      std::size_t left = obj.size();
+      for(const Record& e : obj)
+      {
+         if(!this->reserve(LogObj::maxLength(e.size) + 1))
+         {
+            _dropped += left;
+            break;
+         }
+         left--;
+         const std::int64_t ns = e.nsec();
+         char* dst             = _map + (_length - _map_offset);
+         std::size_t n = LogObj::parse(dst, ns, static_cast<Log::Log>(e.level),
+                                       e.text(), e.size, Callsite::location(e.site));
+         dst[n++] = '\n';
+         _index.add(TimeFormatter::truncate(ns), static_cast<Log::Log>(e.level),
+                    _length, n);
+         _length += n;
+      }
+      // delete store-content
+      obj.clear();
+      return !left;
+   }
+
+   /**
+    * Copies one formatted log and a line break into mapped file
+    *
+    * @param[in] line pointer to formatted log
+    * @param[in] len  length of formatted log
+    * @return false if file could not be opened or grown, see lastError()
+    */
+   bool writeLine(const char* line, const std::size_t len) override
+   {
+      if(_fd < 0 && !this->openFile(O_RDWR | O_CREAT | O_CLOEXEC))
+      {
+         return false;
+      }
+      if(!this->reserve(len + 1))
+      {
+         _dropped++;
+         return false;
+      }
+      char* dst = _map + (_length - _map_offset);
+      std::memcpy(dst, line, len);
+      dst[len] = '\n';
+      _length += len + 1;
+      return true;
+   }
+
+   /**
+    * Appends index entries of closed buckets, mapped pages are written back by the
+    * kernel
+    *
+    * @return false if index file could not be written, see lastError()
+    */
+   bool flush() override { return this->flushIndex(); }
+
+ private:
+   /**
+    * Ensures that the mapping has space for given bytes behind _length, grows and
+    * remaps file if not
+    *
+    * @param[in] need bytes needed
+    * @return false if file could not be grown or mapped, see lastError()
+    */
+   bool reserve(const std::size_t need)
+   {
+      if(_map && _length + need <= _map_offset + _map_size)
+      {
+         return true;
+      }
+      this->unmap();
+
+      const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+      const std::size_t offset = _length & ~(page - 1);
+      std::size_t size         = _length - offset + need;
+      size                     = size < _extent ? _extent : size;
+      size                     = (size + page - 1) & ~(page - 1);
+
+      // allocate blocks, writes into a sparse mapping could fail with SIGBUS
+      if(::fallocate(_fd, 0, static_cast<off_t>(offset), static_cast<off_t>(size)) !=
+         0)
+      {
+         if((errno != EOPNOTSUPP && errno != ENOSYS) ||
+            ::ftruncate(_fd, static_cast<off_t>(offset + size)) != 0)
+         {
+            this->setError("fallocate");
+            return false;
+         }
+      }
+      void* map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd,
+                         static_cast<off_t>(offset));
+      if(map == MAP_FAILED)
+      {
+         this->setError("mmap");
+         return false;
+      }
+      _map        = static_cast<char*>(map);
+      _map_offset = offset;
+      _map_size   = size;
+      return true;
+   }
+
+   /**
+    * Unmaps current extent
+    */
+   void unmap()
+   {
+      if(_map)
+      {
+         ::munmap(_map, _map_size);
+         _map = nullptr;
+      }
+   }
+
+   std::size_t _extent;         ///< bytes the file is grown at once
+   char* _map = nullptr;        ///< mapped part of file
+   std::size_t _map_offset = 0; ///< file offset of _map
+   std::size_t _map_size   = 0; ///< size of _map
+};
+
+} // namespace evo
+
+#endif /* EVOMMAPWRITER_H_ */
@@ -0,0 +1,167 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOMPSCQUEUE_H_
+#define EVOMPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace evo {
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer queue
+ *
+ * Ring buffer of cells, each cell carries a sequence number which tells producers
+ * and the consumer whether the cell is free or filled (D. Vyukov's bounded queue).
+ * Producers only compete on one atomic counter, the consumer never blocks them.
+ *
+ * @note push() may be called from any thread, pop() and empty() only from one
+ * consumer thread at a time.
+ *
+ * @author MSC
+ */
+template<typename T>
+class MpscQueue
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] capacity number of cells, rounded up to the next power of two
+    */
+   explicit MpscQueue(std::size_t capacity) : _head(0), _tail(0)
+   {
+      std::size_t size = 2;
+      while(size < capacity)
+      {
+         size <<= 1;
+      }
+      _mask  = size - 1;
+      _cells = std::unique_ptr<Cell[]>(new Cell[size]);
+      for(std::size_t i = 0; i < size; i++)
+      {
+         _cells[i].seq.store(i, std::memory_order_relaxed);
+      }
+   }
+
+   MpscQueue(const MpscQueue&) = delete;
+   MpscQueue& operator=(const MpscQueue&) = delete;
+
+   /**
+    * Destructor, destroys all elements which were not consumed
+    */
+   ~MpscQueue()
+   {
+      while(this->pop([](T&) {}))
+      {
+      }
+   }
+
+   /**
+    * Enqueues an element, never blocks
+    *
+    * @param[in] value element to move into the queue
+    * @return false if the queue is full, value is untouched in this case
+    */
+   bool push(T&& value)
+   {
+      Cell* cell      = nullptr;
+      std::size_t pos = _head.load(std::memory_order_relaxed);
+      for(;;)
+      {
+         cell            = &_cells[pos & _mask];
+         std::size_t seq = cell->seq.load(std::memory_order_acquire);
+         std::intptr_t diff =
+             static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+         if(diff == 0)
+         {
+            if(_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+               break;
+            }
+         }
+         else if(diff < 0)
+         {
+            return false; // full
+         }
+         else
+         {
+            pos = _head.load(std::memory_order_relaxed);
+         }
+      }
+      new(&cell->storage) T(std::move(value));
+      cell->seq.store(pos + 1, std::memory_order_release);
+      return true;
+   }
+
+   /**
+    * Dequeues one element and hands it to the given function, consumer only
+    *
+    * @param[in] func called with T& of the oldest element, element is destroyed
+    * afterwards
+    * @return false if the queue is empty
+    */
+   template<typename F>
+   bool pop(F&& func)
+   {
+      Cell& cell = _cells[_tail & _mask];
+      if(cell.seq.load(std::memory_order_acquire) != _tail + 1)
+      {
+         return false;
+      }
+      T* elem = reinterpret_cast<T*>(&cell.storage);
+      func(*elem);
+      elem->~T();
+      cell.seq.store(_tail + _mask + 1, std::memory_order_release);
+      ++_tail;
+      return true;
+   }
+
+   /**
+    * Proves if there is an element to consume, consumer only
+    *
+    * @return true if no element is ready
+    */
+   bool empty() const
+   {
+      return _cells[_tail & _mask].seq.load(std::memory_order_acquire) != _tail + 1;
+   }
+
+   /**
+    * Getter for capacity
+    *
+    * @return number of cells
+    */
+   std::size_t capacity() const { return _mask + 1; }
+
+ private:
+   /**
+    * Cell of ring buffer, storage is constructed only while seq marks it filled
+    */
+   struct Cell
+   {
+      std::atomic<std::size_t> seq; ///< sequence number of cell
+      typename std::aligned_storage<sizeof(T), alignof(T)>::type
+          storage; ///< raw storage of element
+   };
+
+   std::unique_ptr<Cell[]> _cells; ///< ring buffer
+   std::size_t _mask;              ///< capacity - 1
+
+   char _pad0[64];                 ///< keeps producers and consumer apart
+   std::atomic<std::size_t> _head; ///< next position for producers
+   char _pad1[64];                 ///< keeps producers and consumer apart
+   std::size_t _tail;              ///< next position for consumer
+};
+
+} // namespace evo
+
+#endif /* EVOMPSCQUEUE_H_ */
@@ -7,6 +7,7 @@
 #define EVOOSTREAMCOLOR_H_
 
 #include <ostream>
+#include <string>
 
 namespace evo {
 
@@ -55,6 +56,16 @@ class OSColor
       return os;
    }
 
+   /**
+    * Getter for escape sequence, e.g. to precompute it
+    *
+    * @return escape sequence of color
+    */
+   std::string str() const
+   {
+      return "\33[" + std::to_string(static_cast<unsigned int>(_col)) + "m";
+   }
+
  private:
    Color _col; ///< defined Colortype
 };
@@ -0,0 +1,266 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVORATELIMIT_H_
+#define EVORATELIMIT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "evo_logger/log/Logger.h"
+#include "evo_logger/time/Clock.h"
+
+namespace evo {
+
+/**
+ * @brief State of one rate limited call site, see EVO_WARN_EVERY_N,
+ * EVO_WARN_FIRST_N and EVO_WARN_THROTTLE in LogMacros.h
+ *
+ * The macros keep one instance in static storage per call site (constant
+ * initialized, no guard), pass() is a single relaxed atomic operation, so
+ * suppressed calls never format their arguments. Suppressed calls are counted,
+ * call sites with suppressed logs are summarized as one WARN log each at most
+ * once per summary interval (see setSummaryInterval(), default 10 s), when
+ * summarize() or Logger::writeLog() is called and when the Logger is destroyed.
+ *
+ * @author MSC
+ */
+class RateLimit
+{
+ public:
+   /**
+    * Kind of limit
+    */
+   enum Kind
+   {
+      EVERY_N,   ///< every Nth call passes, starting with the first
+      FIRST_N,   ///< only the first N calls pass
+      PER_SECOND ///< at most N calls per second pass
+   };
+
+   /**
+    * Constructor
+    *
+    * @param[in] kind kind of limit
+    * @param[in] n    parameter of limit, values < 1 are treated as 1
+    * @param[in] file source file of call site
+    * @param[in] line source line of call site
+    */
+   constexpr RateLimit(const Kind kind, const std::uint64_t n, const char* file,
+                       const int line) :
+       _kind(kind),
+       _n(n ? n : 1), _file(file), _line(line), _count(0), _suppressed(0),
+       _registered(false), _next(nullptr)
+   {
+   }
+
+   RateLimit(const RateLimit&) = delete;
+   RateLimit& operator=(const RateLimit&) = delete;
+
+   /**
+    * Proves if call passes the limit, counts suppressed calls
+    *
+    * @return true if message is to be logged
+    */
+   bool pass()
+   {
+      switch(_kind)
+      {
+         case EVERY_N:
+            if(_count.fetch_add(1, std::memory_order_relaxed) % _n == 0)
+            {
+               return true;
+            }
+            break;
+         case FIRST_N:
+            if(_count.load(std::memory_order_relaxed) < _n &&
+               _count.fetch_add(1, std::memory_order_relaxed) < _n)
+            {
+               return true;
+            }
+            break;
+         case PER_SECOND:
+            if(this->passSecond())
+            {
+               return true;
+            }
+            break;
+      }
+      this->suppress();
+      return false;
+   }
+
+   /**
+    * Logs one WARN summary for every call site with suppressed calls since the
+    * last summary
+    *
+    * @param[in] force if false, only summarizes if the summary interval elapsed
+    */
+   static void summarize(const bool force = true)
+   {
+      RateLimit::summarize(force,
+                           [](const std::string& summary) { log::warn(summary); });
+   }
+
+   /**
+    * Passes one summary for every call site with suppressed calls since the last
+    * summary to report
+    *
+    * @param[in] force  if false, only summarizes if the summary interval elapsed
+    * @param[in] report called with each summary message
+    */
+   template<typename F>
+   static void summarize(const bool force, F report)
+   {
+      std::atomic<std::int64_t>& due = RateLimit::nextSummary();
+      const std::int64_t now         = Clock::nowNSec();
+      const std::int64_t wait        = RateLimit::interval().load();
+      std::int64_t next              = due.load(std::memory_order_relaxed);
+      if(force || !next)
+      {
+         due.store(now + wait, std::memory_order_relaxed);
+         if(!force)
+         {
+            return; // first suppression starts interval
+         }
+      }
+      else if(now < next || !due.compare_exchange_strong(next, now + wait,
+                                                         std::memory_order_relaxed))
+      {
+         return; // not due or other thread summarizes
+      }
+
+      RateLimit* site = RateLimit::head().load(std::memory_order_acquire);
+      for(; site; site = site->_next)
+      {
+         const std::uint64_t count =
+             site->_suppressed.exchange(0, std::memory_order_relaxed);
+         if(count)
+         {
+            report(site->describe(count));
+         }
+      }
+   }
+
+   /**
+    * Setter for interval of periodic summaries
+    *
+    * @param[in] sec interval [s]
+    */
+   static void setSummaryInterval(const double sec)
+   {
+      RateLimit::interval().store(static_cast<std::int64_t>(sec * 1e9),
+                                  std::memory_order_relaxed);
+   }
+
+ private:
+   /**
+    * Proves if call passes in the current second, count is reset each second
+    *
+    * @return true if passed
+    */
+   bool passSecond()
+   {
+      // upper 32 bits: second of window, lower 32 bits: calls in window
+      const std::uint64_t sec =
+          static_cast<std::uint64_t>(Clock::nowNSec() / 1000000000) << 32;
+      std::uint64_t value = _count.fetch_add(1, std::memory_order_relaxed);
+      if((value & ~0xFFFFFFFFull) == sec)
+      {
+         return (value & 0xFFFFFFFFull) < _n;
+      }
+      // new second, only one thread resets the window
+      value++;
+      return _count.compare_exchange_strong(value, sec | 1,
+                                            std::memory_order_relaxed);
+   }
+
+   /**
+    * Counts suppressed call, registers call site for summaries on first
+    * suppression and triggers periodic summary
+    */
+   void suppress()
+   {
+      const std::uint64_t n = _suppressed.fetch_add(1, std::memory_order_relaxed);
+      ThreadStats* stats = StatsRegistry::active();
+      if(stats)
+      {
+         stats->suppressed.add(1);
+      }
+      if(!_registered.load(std::memory_order_relaxed) &&
+         !_registered.exchange(true, std::memory_order_relaxed))
+      {
+         _next = RateLimit::head().load(std::memory_order_relaxed);
+         while(!RateLimit::head().compare_exchange_weak(
+             _next, this, std::memory_order_release, std::memory_order_relaxed))
+         {
+         }
+      }
+      if((n & 63) == 0) // clock is only read every 64th suppressed call
+      {
+         RateLimit::summarize(false);
+      }
+   }
+
+   /**
+    * Builds summary message
+    *
+    * @param[in] count suppressed calls
+    * @return message
+    */
+   std::string describe(const std::uint64_t count) const
+   {
+      const char* name = std::strrchr(_file, '/');
+      std::string msg  = std::string(name ? name + 1 : _file) + ":" +
+                        std::to_string(_line) + ": " + std::to_string(count) +
+                        " logs suppressed (";
+      switch(_kind)
+      {
+         case EVERY_N: msg += "every " + std::to_string(_n) + ")"; break;
+         case FIRST_N: msg += "first " + std::to_string(_n) + ")"; break;
+         case PER_SECOND: msg += std::to_string(_n) + " per second)"; break;
+      }
+      return msg;
+   }
+
+   static std::atomic<RateLimit*>& head()
+   {
+      static std::atomic<RateLimit*> head(nullptr);
+      return head;
+   }
+
+   static std::atomic<std::int64_t>& nextSummary()
+   {
+      static std::atomic<std::int64_t> next(0);
+      return next;
+   }
+
+   static std::atomic<std::int64_t>& interval()
+   {
+      static std::atomic<std::int64_t> interval(10000000000ll);
+      return interval;
+   }
+
+   const Kind _kind;                       ///< kind of limit
+   const std::uint64_t _n;                 ///< parameter of limit
+   const char* _file;                      ///< source file of call site
+   const int _line;                        ///< source line of call site
+   std::atomic<std::uint64_t> _count;      ///< calls (and second for PER_SECOND)
+   std::atomic<std::uint64_t> _suppressed; ///< suppressed calls since last summary
+   std::atomic<bool> _registered;          ///< in list of summarized call sites
+   RateLimit* _next;                       ///< next registered call site
+};
+
+template<typename F>
+inline void summarizeRateLimits(F report)
+{
+   RateLimit::summarize(true, report);
+}
+
+} // namespace evo
+
+#endif /* EVORATELIMIT_H_ */
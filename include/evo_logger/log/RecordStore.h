@@ -0,0 +1,272 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVORECORDSTORE_H_
+#define EVORECORDSTORE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "evo_logger/log/Callsite.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/Time.h"
+
+namespace evo {
+
+/**
+ * Fixed size header of a stored log, the message follows directly behind it
+ *
+ * @author MSC
+ */
+struct Record
+{
+   std::uint64_t stamp;  ///< raw timestamp (see Clock)
+   std::uint32_t level;  ///< log level
+   std::uint32_t size;   ///< length of message
+   const Callsite* site; ///< call site, nullptr if unknown
+
+   /**
+    * Getter for message
+    *
+    * @return pointer to message, not null terminated
+    */
+   const char* text() const { return reinterpret_cast<const char*>(this + 1); }
+
+   /**
+    * Getter for timestamp
+    *
+    * @return nanoseconds since epoch
+    */
+   std::int64_t nsec() const { return Clock::toNSec(stamp); }
+
+   /**
+    * Getter for timestamp
+    *
+    * @return timestamp as evo::Time
+    */
+   Time time() const { return Time::fromNSec(this->nsec()); }
+};
+
+/**
+ * @brief Compact storage of logs in large reused chunks
+ *
+ * Logs are packed as Record header + message (8 byte aligned) into chunks of
+ * chunk_size bytes, so a chunk holds thousands of logs with one allocation.
+ * clear() keeps up to keep_chunks chunks for reuse, the iteration is sequential
+ * through memory.
+ *
+ * @author MSC
+ */
+class RecordStore
+{
+ private:
+   /**
+    * Memory block for records
+    */
+   struct Chunk
+   {
+      std::unique_ptr<char[]> data; ///< memory
+      std::size_t capacity;         ///< size of data
+      std::size_t used;             ///< used bytes of data
+   };
+
+ public:
+   /**
+    * Forward iterator over stored records
+    */
+   class const_iterator
+   {
+    public:
+      const_iterator(const std::vector<Chunk>* chunks, std::size_t chunk,
+                     std::size_t pos) :
+          _chunks(chunks), _chunk(chunk), _pos(pos)
+      {
+         this->skipEmpty();
+      }
+
+      const Record& operator*() const
+      {
+         return *reinterpret_cast<const Record*>(&(*_chunks)[_chunk].data[_pos]);
+      }
+
+      const Record* operator->() const { return &(**this); }
+
+      const_iterator& operator++()
+      {
+         _pos += RecordStore::footprint((**this).size);
+         this->skipEmpty();
+         return *this;
+      }
+
+      bool operator==(const const_iterator& rhs) const
+      {
+         return _chunk == rhs._chunk && _pos == rhs._pos;
+      }
+
+      bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+
+    private:
+      void skipEmpty()
+      {
+         while(_chunk < _chunks->size() && _pos >= (*_chunks)[_chunk].used)
+         {
+            _chunk++;
+            _pos = 0;
+         }
+      }
+
+      const std::vector<Chunk>* _chunks; ///< chunks of store
+      std::size_t _chunk;                ///< current chunk
+      std::size_t _pos;                  ///< offset in current chunk
+   };
+
+   /**
+    * Constructor
+    *
+    * @param[in] chunk_size  size of one chunk in bytes
+    * @param[in] keep_chunks number of chunks kept by clear() for reuse
+    */
+   explicit RecordStore(const std::size_t chunk_size  = 1 << 20,
+                        const std::size_t keep_chunks = 4) :
+       _chunk_size(chunk_size),
+       _keep_chunks(keep_chunks)
+   {
+   }
+
+   /**
+    * Stores a log
+    *
+    * @throw std::bad_alloc if a new chunk can not be allocated
+    *
+    * @param[in] stamp raw timestamp (see Clock)
+    * @param[in] level log level
+    * @param[in] text  pointer to message
+    * @param[in] len   length of message
+    * @param[in] site  call site, may be nullptr
+    */
+   void append(const std::uint64_t stamp, Log::Log level, const char* text,
+               const std::size_t len, const Callsite* site = nullptr)
+   {
+      const std::size_t need = footprint(len);
+      Chunk* chunk           = this->chunkFor(need);
+
+      Record* rec = reinterpret_cast<Record*>(&chunk->data[chunk->used]);
+      rec->stamp  = stamp;
+      rec->level  = static_cast<std::uint32_t>(level);
+      rec->size   = static_cast<std::uint32_t>(len);
+      rec->site   = site;
+      std::memcpy(rec + 1, text, len);
+
+      chunk->used += need;
+      _count++;
+      _bytes += need;
+   }
+
+   /**
+    * Removes all logs, keeps up to keep_chunks chunks for reuse
+    */
+   void clear()
+   {
+      if(_chunks.size() > _keep_chunks)
+      {
+         _chunks.resize(_keep_chunks);
+      }
+      for(auto& c : _chunks)
+      {
+         c.used = 0;
+      }
+      _current = 0;
+      _count   = 0;
+      _bytes   = 0;
+   }
+
+   /**
+    * Removes all logs and releases all memory
+    */
+   void release()
+   {
+      std::vector<Chunk>().swap(_chunks);
+      this->clear();
+   }
+
+   /**
+    * Getter for number of stored logs
+    *
+    * @return number of logs
+    */
+   std::size_t size() const { return _count; }
+
+   /**
+    * Proves if store is empty
+    *
+    * @return true if no log is stored
+    */
+   bool empty() const { return _count == 0; }
+
+   /**
+    * Getter for used memory of stored logs (headers, messages, alignment)
+    *
+    * @return bytes
+    */
+   std::size_t bytes() const { return _bytes; }
+
+   const_iterator begin() const { return const_iterator(&_chunks, 0, 0); }
+
+   const_iterator end() const { return const_iterator(&_chunks, _chunks.size(), 0); }
+
+   /**
+    * Memory needed for a log
+    *
+    * @param[in] len length of message
+    * @return bytes for header + message, 8 byte aligned
+    */
+   static std::size_t footprint(const std::size_t len)
+   {
+      return (sizeof(Record) + len + 7) & ~static_cast<std::size_t>(7);
+   }
+
+ private:
+   /**
+    * Finds chunk with enough space, takes next kept chunk or allocates a new one
+    *
+    * @param[in] need bytes needed
+    * @return chunk
+    */
+   Chunk* chunkFor(const std::size_t need)
+   {
+      if(_current < _chunks.size() &&
+         _chunks[_current].used + need <= _chunks[_current].capacity)
+      {
+         return &_chunks[_current];
+      }
+      if(_current < _chunks.size() && _chunks[_current].used)
+      {
+         _current++;
+      }
+      if(_current < _chunks.size() && need <= _chunks[_current].capacity)
+      {
+         return &_chunks[_current];
+      }
+      const std::size_t capacity = need > _chunk_size ? need : _chunk_size;
+      Chunk chunk                = {std::unique_ptr<char[]>(new char[capacity]), capacity, 0};
+      _chunks.insert(_chunks.begin() + static_cast<std::ptrdiff_t>(_current),
+                     std::move(chunk));
+      return &_chunks[_current];
+   }
+
+   std::vector<Chunk> _chunks;   ///< chunks, used ones first
+   std::size_t _current = 0;     ///< chunk which is filled
+   std::size_t _count   = 0;     ///< number of stored logs
+   std::size_t _bytes   = 0;     ///< used bytes
+   std::size_t _chunk_size;      ///< default chunk size
+   std::size_t _keep_chunks;     ///< chunks kept by clear()
+};
+
+} // namespace evo
+
+#endif /* EVORECORDSTORE_H_ */
@@ -0,0 +1,67 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOROTATIONPOLICY_H_
+#define EVOROTATIONPOLICY_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace evo {
+
+/**
+ * @brief Triggers for starting a new log file segment and retention limits
+ *
+ * The log file is closed and a new segment "<file>.<n>.log" is started as soon as
+ * one trigger fires (checked whenever stored logs are written). Closed segments
+ * are compressed to .gz (if built with zlib) and old files of the logger, also
+ * from previous runs, are deleted by a background thread (see LogArchiver). A
+ * value of 0 disables a trigger or limit, by default nothing is rotated.
+ *
+ * Following code shows usage:
+ * @code
+ * evo::RotationPolicy policy;
+ * policy.max_bytes       = 100 << 20; // 100 MiB segments
+ * policy.max_total_bytes = 2ull << 30; // keep 2 GiB
+ * evo::log::get().setRotationPolicy(policy);
+ * @endcode
+ *
+ * @author MSC
+ */
+struct RotationPolicy
+{
+   std::size_t max_bytes         = 0;    ///< bytes of a segment
+   double max_interval           = 0.0;  ///< [s] since segment was started
+   std::size_t max_files         = 0;    ///< files of logger kept on disk
+   std::uint64_t max_total_bytes = 0;    ///< bytes of logger kept on disk
+   bool compress                 = true; ///< compress closed segments
+
+   /**
+    * Proves if a new segment has to be started
+    *
+    * @param[in] bytes   length of current segment
+    * @param[in] elapsed [s] since current segment was started
+    * @return true if one trigger fires
+    */
+   bool due(const std::size_t bytes, const double elapsed) const
+   {
+      return (max_bytes && bytes >= max_bytes) ||
+             (max_interval > 0.0 && elapsed >= max_interval);
+   }
+
+   /**
+    * Proves if any trigger or limit is set
+    *
+    * @return true if enabled
+    */
+   bool enabled() const
+   {
+      return max_bytes || max_interval > 0.0 || max_files || max_total_bytes;
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOROTATIONPOLICY_H_ */
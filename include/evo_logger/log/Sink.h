@@ -0,0 +1,293 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOSINK_H_
+#define EVOSINK_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "evo_logger/log/Encoder.h"
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/log/MpscQueue.h"
+
+namespace evo {
+
+/**
+ * Log encoded once per format by Logger and shared by all sinks accepting its
+ * level
+ */
+struct LogLine
+{
+   std::int64_t ns;  ///< timestamp [ns] since epoch
+   Log::Log level;   ///< log level
+   std::string text; ///< encoded log (see Encoder) without line break
+};
+
+/**
+ * @brief Base class for additional log outputs, see Logger::addSink()
+ *
+ * Every sink has its own level mask and its own bounded queue drained by its own
+ * thread, so a slow sink (e.g. a file on a network share) never holds back the
+ * logging threads or the other sinks. If the queue is full, logs are dropped for
+ * this sink only and counted (see getDroppedCount()).
+ *
+ * Derived classes implement write() for one log and optionally flush(), which is
+ * called whenever the queue ran empty. Both are only called by the sink thread.
+ *
+ * Logs are written as text like the log file by default, setFormat() switches to
+ * JSON or logfmt lines, structured logs carry their fields there (see Field).
+ *
+ * @note derived classes have to call stop() first in their destructor, the
+ * thread must not call write() of a destroyed object
+ *
+ * @author MSC
+ */
+class Sink
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] level    log levels accepted by this sink
+    * @param[in] capacity number of logs the queue can hold (power of two)
+    */
+   explicit Sink(const LogType level = Log::ALL, const std::size_t capacity = 4096) :
+       _level(level), _queue(capacity)
+   {
+   }
+
+   Sink(const Sink&) = delete;
+   Sink& operator=(const Sink&) = delete;
+
+   /**
+    * Destructor stops thread
+    */
+   virtual ~Sink() { this->stop(); }
+
+   /**
+    * Setter for accepted log levels
+    *
+    * @param[in] level as Log-enum (e.G. Log::INFO), more levels can be appendend
+    * with |-operator
+    */
+   void setLevel(const LogType level)
+   {
+      _level.store(level, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_on_level)
+      {
+         _on_level();
+      }
+   }
+
+   /**
+    * Getter for accepted log levels
+    *
+    * @return level mask
+    */
+   LogType getLevel() const { return _level.load(std::memory_order_relaxed); }
+
+   /**
+    * Setter for output format, applies to logs enqueued afterwards
+    *
+    * @param[in] format format of LogLine::text passed to write()
+    */
+   void setFormat(const LineFormat::LineFormat format)
+   {
+      _format.store(format, std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for output format
+    *
+    * @return format
+    */
+   LineFormat::LineFormat getFormat() const
+   {
+      return static_cast<LineFormat::LineFormat>(
+          _format.load(std::memory_order_relaxed));
+   }
+
+   /**
+    * Proves if sink accepts logs of given level
+    *
+    * @param[in] level log level
+    * @return true if accepted
+    */
+   bool accepts(Log::Log level) const
+   {
+      return static_cast<LogType>(level) & _level.load(std::memory_order_relaxed);
+   }
+
+   /**
+    * Enqueues log, returns without waiting for the sink
+    *
+    * @param[in] line formatted log
+    * @return false if queue was full, log is dropped
+    */
+   bool push(const std::shared_ptr<const LogLine>& line)
+   {
+      std::shared_ptr<const LogLine> copy(line);
+      if(!_queue.push(std::move(copy)))
+      {
+         _dropped.fetch_add(1, std::memory_order_relaxed);
+         return false;
+      }
+      _pushed.fetch_add(1, std::memory_order_relaxed);
+      // pairs with fence in run(), either the thread sees the log or we see it sleep
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(_sleeping.load(std::memory_order_relaxed))
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _cv.notify_all();
+      }
+      return true;
+   }
+
+   /**
+    * Starts thread, called by Logger::addSink()
+    *
+    * @param[in] on_level called after setLevel()
+    */
+   void start(std::function<void()> on_level = nullptr)
+   {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _on_level = on_level;
+      if(!_thread.joinable() && !_stop)
+      {
+         _thread = std::thread(&Sink::run, this);
+      }
+   }
+
+   /**
+    * Writes all enqueued logs and stops thread, logs pushed afterwards stay queued
+    */
+   void stop()
+   {
+      {
+         std::lock_guard<std::mutex> lock(_mutex);
+         _stop     = true;
+         _on_level = nullptr;
+      }
+      _cv.notify_all();
+      if(_thread.joinable())
+      {
+         _thread.join();
+      }
+   }
+
+   /**
+    * Waits until every log enqueued before this call is written and flushed
+    */
+   void sync()
+   {
+      const std::uint64_t target = _pushed.load(std::memory_order_relaxed);
+      std::unique_lock<std::mutex> lock(_mutex);
+      while(_thread.joinable() && _flushed < target)
+      {
+         _cv.notify_all();
+         _cv.wait_for(lock, std::chrono::milliseconds(10));
+      }
+   }
+
+   /**
+    * Getter for number of logs dropped because the queue was full
+    *
+    * @return dropped logs
+    */
+   std::uint64_t getDroppedCount() const
+   {
+      return _dropped.load(std::memory_order_relaxed);
+   }
+
+ protected:
+   /**
+    * Writes one log
+    *
+    * @param[in] line formatted log
+    */
+   virtual void write(const LogLine& line) = 0;
+
+   /**
+    * Called when the queue ran empty, e.g. to write buffered data
+    */
+   virtual void flush() {}
+
+ private:
+   /**
+    * Thread function, writes logs in batches until stop() is called and the queue
+    * is empty
+    */
+   void run()
+   {
+      const std::size_t batch = 256;
+      std::uint64_t done      = 0;
+      unsigned int idle       = 0;
+      for(;;)
+      {
+         std::size_t n = 0;
+         while(n < batch && _queue.pop([this](std::shared_ptr<const LogLine>& line) {
+                  this->write(*line);
+                  line.reset();
+               }))
+         {
+            n++;
+         }
+         done += n;
+         if(n)
+         {
+            idle = 0;
+            continue;
+         }
+         if(idle++ < 64) // logs come in bursts, sleeping costs a wakeup per log
+         {
+            std::this_thread::yield();
+            continue;
+         }
+         this->flush();
+
+         std::unique_lock<std::mutex> lock(_mutex);
+         _flushed = done;
+         _cv.notify_all();
+         if(_stop)
+         {
+            return;
+         }
+         _sleeping.store(true, std::memory_order_relaxed);
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if(_queue.empty())
+         {
+            _cv.wait_for(lock, std::chrono::milliseconds(100));
+         }
+         _sleeping.store(false, std::memory_order_relaxed);
+         idle = 0;
+      }
+   }
+
+   std::atomic<LogType> _level;                     ///< accepted log levels
+   std::atomic<int> _format{LineFormat::TEXT};      ///< LineFormat of logs
+   MpscQueue<std::shared_ptr<const LogLine>> _queue; ///< logs not written yet
+   std::atomic<std::uint64_t> _pushed{0};           ///< logs enqueued
+   std::atomic<std::uint64_t> _dropped{0};          ///< logs dropped, queue full
+   std::atomic<bool> _sleeping{false};              ///< thread waits for logs
+   std::uint64_t _flushed = 0;                      ///< logs written and flushed
+   bool _stop             = false;                  ///< stops thread
+   std::function<void()> _on_level;                 ///< called after setLevel()
+   std::thread _thread;                             ///< writes logs
+   std::mutex _mutex;            ///< protects _flushed, _stop, _on_level
+   std::condition_variable _cv;  ///< wakes thread and sync()
+};
+
+} // namespace evo
+
+#endif /* EVOSINK_H_ */
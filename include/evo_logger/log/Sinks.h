@@ -0,0 +1,271 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOSINKS_H_
+#define EVOSINKS_H_
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogType.h"
+#include "evo_logger/log/MmapWriter.h"
+#include "evo_logger/log/Sink.h"
+#include "evo_logger/log/Writer.h"
+
+namespace evo {
+
+/**
+ * @brief Sink writing logs to an ostream (e.g. std::cerr), one per line
+ *
+ * @author MSC
+ */
+class StreamSink : public Sink
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] os       output, has to outlive the sink
+    * @param[in] level    accepted log levels
+    * @param[in] capacity number of logs the queue can hold
+    */
+   explicit StreamSink(std::ostream& os, const LogType level = Log::ALL,
+                       const std::size_t capacity = 4096) :
+       Sink(level, capacity),
+       _os(os)
+   {
+   }
+
+   ~StreamSink() override { this->stop(); }
+
+ protected:
+   void write(const LogLine& line) override
+   {
+      _os.write(line.text.data(), static_cast<std::streamsize>(line.text.size()));
+      _os.put('\n');
+   }
+
+   void flush() override { _os.flush(); }
+
+ private:
+   std::ostream& _os; ///< output
+};
+
+/**
+ * @brief Sink writing logs to an additional log file
+ *
+ * Uses Writer or MmapWriter like the log file of the Logger, but without
+ * rotation. Failed writes are counted, see getFailedCount().
+ *
+ * @author MSC
+ */
+class FileSink : public Sink
+{
+ public:
+   /**
+    * Constructor, file is opened on first log
+    *
+    * @param[in] file     path of file, logs are appended
+    * @param[in] mode     writer for file
+    * @param[in] level    accepted log levels
+    * @param[in] capacity number of logs the queue can hold
+    */
+   explicit FileSink(const std::string& file,
+                     const FileMode::FileMode mode = FileMode::STREAM,
+                     const LogType level = Log::ALL,
+                     const std::size_t capacity = 4096) :
+       Sink(level, capacity),
+       _writer(mode == FileMode::MMAP ? new MmapWriter(file) : new Writer(file))
+   {
+   }
+
+   ~FileSink() override { this->stop(); }
+
+   /**
+    * Getter for number of logs which could not be written
+    *
+    * @return failed logs
+    */
+   std::uint64_t getFailedCount() const
+   {
+      return _failed.load(std::memory_order_relaxed);
+   }
+
+ protected:
+   void write(const LogLine& line) override
+   {
+      if(!_writer->writeLine(line.text.data(), line.text.size()))
+      {
+         _failed.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+
+   void flush() override { _writer->flush(); }
+
+ private:
+   std::unique_ptr<Writer> _writer;       ///< writer for file
+   std::atomic<std::uint64_t> _failed{0}; ///< logs not written
+};
+
+/**
+ * @brief Sink keeping the latest logs in memory, e.g. for a diagnostics view
+ *
+ * @author MSC
+ */
+class RingSink : public Sink
+{
+ public:
+   /**
+    * Constructor
+    *
+    * @param[in] count    number of latest logs kept
+    * @param[in] level    accepted log levels
+    * @param[in] capacity number of logs the queue can hold
+    */
+   explicit RingSink(const std::size_t count, const LogType level = Log::ALL,
+                     const std::size_t capacity = 4096) :
+       Sink(level, capacity),
+       _count(count)
+   {
+   }
+
+   ~RingSink() override { this->stop(); }
+
+   /**
+    * Copies kept logs, call sync() before to include all logs enqueued so far
+    *
+    * @return latest logs, oldest first
+    */
+   std::vector<LogLine> snapshot() const
+   {
+      std::lock_guard<std::mutex> lock(_ring_mutex);
+      return std::vector<LogLine>(_ring.begin(), _ring.end());
+   }
+
+ protected:
+   void write(const LogLine& line) override
+   {
+      std::lock_guard<std::mutex> lock(_ring_mutex);
+      if(_ring.size() == _count)
+      {
+         _ring.pop_front();
+      }
+      if(_count)
+      {
+         _ring.push_back(line);
+      }
+   }
+
+ private:
+   std::size_t _count;              ///< number of latest logs kept
+   std::deque<LogLine> _ring;       ///< latest logs
+   mutable std::mutex _ring_mutex;  ///< protects _ring
+};
+
+/**
+ * @brief Sink sending every log as one datagram to a local (unix domain) socket
+ *
+ * Sending never blocks, logs are dropped and counted (see getFailedCount()) if no
+ * receiver is bound to the path or its buffer is full. Receive e.g. with
+ * "socat UNIX-RECV:<path> -".
+ *
+ * @author MSC
+ */
+class SocketSink : public Sink
+{
+ public:
+   /**
+    * Constructor, creates socket, see isOpen()
+    *
+    * @param[in] path     path of receiving socket
+    * @param[in] level    accepted log levels
+    * @param[in] capacity number of logs the queue can hold
+    */
+   explicit SocketSink(const std::string& path, const LogType level = Log::ALL,
+                       const std::size_t capacity = 4096) :
+       Sink(level, capacity)
+   {
+      std::memset(&_addr, 0, sizeof(_addr));
+      _addr.sun_family = AF_UNIX;
+      if(path.size() >= sizeof(_addr.sun_path))
+      {
+         _error = "socket path too long: " + path;
+         return;
+      }
+      std::memcpy(_addr.sun_path, path.c_str(), path.size() + 1);
+      _fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+      if(_fd < 0)
+      {
+         _error = std::string("socket: ") + std::strerror(errno);
+      }
+   }
+
+   ~SocketSink() override
+   {
+      this->stop();
+      if(_fd >= 0)
+      {
+         ::close(_fd);
+      }
+   }
+
+   /**
+    * Proves if socket was created
+    *
+    * @return true if usable, else see lastError()
+    */
+   bool isOpen() const { return _fd >= 0; }
+
+   /**
+    * Getter for reason of failed creation
+    *
+    * @return error message
+    */
+   const std::string& lastError() const { return _error; }
+
+   /**
+    * Getter for number of logs which could not be sent
+    *
+    * @return failed logs
+    */
+   std::uint64_t getFailedCount() const
+   {
+      return _failed.load(std::memory_order_relaxed);
+   }
+
+ protected:
+   void write(const LogLine& line) override
+   {
+      if(_fd < 0 || ::sendto(_fd, line.text.data(), line.text.size(),
+                             MSG_DONTWAIT | MSG_NOSIGNAL,
+                             reinterpret_cast<const struct sockaddr*>(&_addr),
+                             sizeof(_addr)) < 0)
+      {
+         _failed.fetch_add(1, std::memory_order_relaxed);
+      }
+   }
+
+ private:
+   int _fd = -1;                          ///< datagram socket
+   struct sockaddr_un _addr;              ///< receiver
+   std::string _error;                    ///< reason of failed creation
+   std::atomic<std::uint64_t> _failed{0}; ///< logs not sent
+};
+
+} // namespace evo
+
+#endif /* EVOSINKS_H_ */
@@ -6,19 +6,53 @@
 #ifndef WRITER_H_
 #define WRITER_H_
 
-#include <iostream>
-#include <fstream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
 #include <vector>
-#include <cassert>
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "evo_logger/log/LogIndex.h"
 #include "evo_logger/log/LogType.h"
+#include "evo_logger/log/RecordStore.h"
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/TimeFormatter.h"
 
 namespace evo {
 
+namespace FileMode {
+/**
+ * Writer used for the log file, see Logger::initialize()
+ */
+enum FileMode
+{
+   STREAM, ///< Writer, buffered write() calls
+   MMAP    ///< MmapWriter, preallocated and memory mapped file
+};
+} // namespace FileMode
+
 /**
  * Class for writing log-messages into a given file, logs will be appended in file.
  *
- * @todo error handling when file is unable to write...
+ * The file is opened on first write and kept open, formatted logs are collected in
+ * a page aligned buffer which is written with one write() call when it is full or
+ * flush() is called. If the file can not be opened or written, the functions
+ * return false and lastError() describes the reason, a failed open is retried at
+ * most once per second. If the buffer can not be written, its unwritten tail is
+ * kept for the next flush(), logs which do not fit into the buffer meanwhile are
+ * dropped (see dropped()). Logs longer than the buffer are written directly after
+ * the buffer. Derived classes (MmapWriter) replace write() and flush().
+ *
+ * Logs written with write() are also added to the sparse index "<file>.idx" (see
+ * LogIndex), which lets LogReader skip the parts of the file outside of a queried
+ * time range or without logs of the queried levels. The index is appended on
+ * flush(), after the logs it refers to.
  *
  * @author MSC
  */
@@ -28,38 +62,446 @@ class Writer
    /**
     * Constructor
     *
-    * @param[in] file for writing logs
+    * @param[in] file        for writing logs
+    * @param[in] buffer_size size of write buffer in bytes
+    */
+   Writer(std::string file, const std::size_t buffer_size = 1 << 18) :
+       _file(file), _index(file + ".idx"), _buf(nullptr, std::free),
+       _capacity(buffer_size < BUFFER_ALIGN ? static_cast<std::size_t>(BUFFER_ALIGN)
+                                            : buffer_size)
+   {
+   }
+
+   Writer(const Writer&) = delete;
+   Writer& operator=(const Writer&) = delete;
+
+   /**
+    * Destructor closes file, see close()
     */
-   Writer(std::string file) : _file(file) {}
+   virtual ~Writer() { this->close(); }
 
    /**
-    * Writes and deletes given logs to file, logs will be appended in file.
+    * Writes buffer and index and closes file, index entries of logs which could
+    * not be written are dropped. A later write() opens the file again.
     *
-    * @param[in, out] obj containing all logs to write
+    * @return false if logs or index could not be written, see lastError()
     */
-   void write(std::vector<LogObj>& obj)
+   virtual bool close()
    {
-      std::ofstream out;
+      bool ok = this->flush();
+      if(!ok)
+      {
+         _index.truncate(_length - _used);
+      }
+      if(!_index.finish())
+      {
+         _error = _index.lastError();
+         ok     = false;
+      }
+      if(_fd >= 0)
+      {
+         ::close(_fd);
+         _fd = -1;
+      }
+      return ok;
+   }
 
-      out.open(_file.c_str(), std::ios::app | std::ios::out);
-      if(!out)
+   /**
+    * Formats given logs into the write buffer and deletes them from the store,
+    * full buffers are written to file (appended), the rest stays buffered until
+    * flush()
+    *
+    * @param[in, out] obj containing all logs to write, kept if file can not be
+    * opened
+    * @return false if file could not be opened or written, see lastError()
+    */
+   virtual bool write(RecordStore& obj)
+   {
+      if(obj.empty())
+      {
+         return true;
+      }
+      if(!this->open())
       {
-         /*error*/
-         // todo
-         return;
+         return false;
       }
 
-      for(auto& e : obj)
+      bool ok = true;
+      for(const Record& e : obj)
       {
-         out << LogObj::parse(e) << std::endl;
+         const std::int64_t ns    = e.nsec();
+         const std::size_t offset = _length;
+         LogObj::parse(_line, ns, static_cast<Log::Log>(e.level), e.text(), e.size,
+                       Callsite::location(e.site));
+         _line += '\n';
+         if(!this->append(_line.data(), _line.size()))
+         {
+            ok = false;
+            _dropped++;
+            continue; // not in file, not indexed
+         }
+         _index.add(TimeFormatter::truncate(ns), static_cast<Log::Log>(e.level),
+                    offset, _line.size());
       }
-      out.close();
-      // delete vector-content
+      // delete store-content
       obj.clear();
+      return ok;
+   }
+
+   /**
+    * Appends one formatted log and a line break to the write buffer (used by
+    * FileSink)
+    *
+    * @param[in] line pointer to formatted log
+    * @param[in] len  length of formatted log
+    * @return false if file could not be opened or written, see lastError()
+    */
+   virtual bool writeLine(const char* line, const std::size_t len)
+   {
+      if(!this->open())
+      {
+         return false;
+      }
+      if(!this->reserve(len + 1) || !this->append(line, len) ||
+         !this->append("\n", 1))
+      {
+         _dropped++;
+         return false;
+      }
+      return true;
+   }
+
+   /**
+    * Writes buffered logs to file, then the index entries of closed buckets
+    *
+    * On error the unwritten tail is moved to the front of the buffer and the index
+    * entries are kept, both are written by the next successful flush().
+    *
+    * @return false if file could not be written, see lastError()
+    */
+   virtual bool flush()
+   {
+      if(!_used)
+      {
+         return this->flushIndex();
+      }
+      const char* data = _buf.get();
+      std::size_t left = _used;
+      while(left)
+      {
+         const ssize_t n = ::write(_fd, data, left);
+         if(n < 0)
+         {
+            if(errno == EINTR)
+            {
+               continue;
+            }
+            this->setError("write");
+            std::memmove(_buf.get(), data, left);
+            _used = left;
+            return false;
+         }
+         data += n;
+         left -= static_cast<std::size_t>(n);
+      }
+      _used = 0;
+      return this->flushIndex();
+   }
+
+   /**
+    * Getter for reason of last failed open or write
+    *
+    * @return error message, empty if no error occured
+    */
+   const std::string& lastError() const { return _error; }
+
+   /**
+    * Getter for log file
+    *
+    * @return path of log file
+    */
+   const std::string& getFile() const { return _file; }
+
+   /**
+    * Getter for length of log file, including logs not written yet
+    *
+    * @return bytes
+    */
+   std::size_t length() const { return _length; }
+
+   /**
+    * Getter for bytes appended to log file by this writer, including logs not
+    * written yet
+    *
+    * @return bytes
+    */
+   std::size_t appended() const { return _length - _opened; }
+
+   /**
+    * Getter for number of logs dropped because the file could not be written
+    *
+    * @return dropped logs since construction
+    */
+   std::size_t dropped() const { return _dropped; }
+
+ protected:
+   /**
+    * Opens _file with given flags and gets its length, a failed open is retried
+    * at most once per second
+    *
+    * The file keeps a shared flock() while open, LogArchiver only deletes files it
+    * can lock exclusively (also of other processes logging with the same name).
+    * If the file was deleted while waiting for the lock, it is created again. A
+    * failed lock is reported by lastError(), the file is written anyway. A zero
+    * filled tail (left by a crash of MmapWriter) is cut off, see trimZeros().
+    *
+    * @param[in] flags flags for open()
+    * @return true if file is open
+    */
+   bool openFile(const int flags)
+   {
+      const std::int64_t now = Clock::nowNSec();
+      if(_failed_at && now - _failed_at < 1000000000)
+      {
+         return false;
+      }
+      struct stat st;
+      bool stated    = false;
+      int lock_error = 0;
+      for(int tries = 0; tries < 3; tries++)
+      {
+         _fd = ::open(_file.c_str(), flags, 0666);
+         if(_fd < 0)
+         {
+            this->setError("open");
+            _failed_at = now;
+            return false;
+         }
+         lock_error = this->lockShared() ? 0 : errno;
+         stated     = ::fstat(_fd, &st) == 0;
+         if(lock_error || !stated || st.st_nlink > 0)
+         {
+            break;
+         }
+         ::close(_fd); // deleted by LogArchiver while waiting for the lock
+         _fd = -1;
+      }
+      if(_fd < 0)
+      {
+         _error     = "open " + _file + ": deleted while opening";
+         _failed_at = now;
+         return false;
+      }
+      _failed_at = 0;
+      _error.clear();
+      if(lock_error)
+      {
+         _error = "lock " + _file + ": " + std::strerror(lock_error);
+      }
+      _length = stated ? this->trimZeros(static_cast<std::size_t>(st.st_size)) : 0;
+      _opened = _length;
+      return true;
+   }
+
+   /**
+    * Appends index entries of closed buckets to index file
+    *
+    * @return false if index file could not be written, see lastError()
+    */
+   bool flushIndex()
+   {
+      if(_index.flush())
+      {
+         return true;
+      }
+      _error = _index.lastError();
+      return false;
    }
 
+   /**
+    * Cuts zero bytes off the end of the open file, so new logs follow the last
+    * log instead of the zero filled rest of an extent of a crashed MmapWriter
+    * (LogReader would read the zeros as part of that log)
+    *
+    * @param[in] size size of file
+    * @return length of file without zeros, size if it could not be truncated (see
+    * lastError())
+    */
+   std::size_t trimZeros(const std::size_t size)
+   {
+      const int fd = size ? ::open(_file.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+      if(fd < 0)
+      {
+         return size;
+      }
+      std::vector<char> buf(1 << 16);
+      std::size_t end = size;
+      while(end)
+      {
+         const std::size_t n = end < buf.size() ? end : buf.size();
+         if(::pread(fd, buf.data(), n, static_cast<off_t>(end - n)) !=
+            static_cast<ssize_t>(n))
+         {
+            break; // keep rest
+         }
+         std::size_t i = n;
+         while(i && !buf[i - 1])
+         {
+            i--;
+         }
+         end -= n - i;
+         if(i)
+         {
+            break;
+         }
+      }
+      ::close(fd);
+      if(end != size && ::ftruncate(_fd, static_cast<off_t>(end)) != 0)
+      {
+         this->setError("truncate");
+         return size;
+      }
+      return end;
+   }
+
+   /**
+    * Takes shared flock() of _fd, waits while a LogArchiver holds its exclusive
+    * lock for deleting the file
+    *
+    * @return false if lock failed, see errno
+    */
+   bool lockShared()
+   {
+      if(::flock(_fd, LOCK_SH | LOCK_NB) == 0)
+      {
+         return true;
+      }
+      while(errno == EWOULDBLOCK || errno == EINTR)
+      {
+         if(::flock(_fd, LOCK_SH) == 0)
+         {
+            return true;
+         }
+      }
+      return false;
+   }
+
+   /**
+    * Sets _error from errno
+    *
+    * @param[in] op name of failed operation
+    */
+   void setError(const char* op)
+   {
+      _error = std::string(op) + " " + _file + ": " + std::strerror(errno);
+   }
+
+   std::string _file;       ///< File for writing logs
+   int _fd = -1;            ///< descriptor of _file
+   std::string _error;      ///< last error
+   std::size_t _length = 0; ///< length of file including buffered logs
+   std::size_t _opened = 0;  ///< length of file when it was opened
+   std::size_t _dropped = 0; ///< logs not written, see dropped()
+   LogIndex _index;          ///< sparse index of logs written with write()
+
  private:
-   std::string _file; ///< File for writing logs
+   static const std::size_t BUFFER_ALIGN = 4096; ///< alignment of write buffer
+
+   /**
+    * Opens file and allocates buffer if not done yet
+    *
+    * @return true if file is open
+    */
+   bool open()
+   {
+      if(_fd >= 0)
+      {
+         return true;
+      }
+      if(!_buf)
+      {
+         void* mem = nullptr;
+         if(posix_memalign(&mem, BUFFER_ALIGN, _capacity) != 0)
+         {
+            _error = "no memory for write buffer of " + _file;
+            return false;
+         }
+         _buf.reset(static_cast<char*>(mem));
+      }
+      return this->openFile(O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC);
+   }
+
+   /**
+    * Makes room for len bytes in buffer, writes buffer to file if needed
+    *
+    * @param[in] len bytes to append, larger than buffer empties the buffer
+    * @return false if buffer could not be written and has not enough room left
+    */
+   bool reserve(const std::size_t len)
+   {
+      const std::size_t need = len < _capacity ? len : _capacity;
+      return _capacity - _used >= need || Writer::flush() ||
+             _capacity - _used >= need; // flush() may have written a part
+   }
+
+   /**
+    * Copies data into buffer, data longer than the buffer is written directly
+    * after the buffer was written
+    *
+    * @return false if data could not be appended, nothing is appended then
+    * (dropped data does not count for length())
+    */
+   bool append(const char* data, const std::size_t len)
+   {
+      if(!this->reserve(len))
+      {
+         return false;
+      }
+      if(len > _capacity)
+      {
+         return this->writeDirect(data, len); // buffer is empty, see reserve()
+      }
+      std::memcpy(_buf.get() + _used, data, len);
+      _used += len;
+      _length += len;
+      return true;
+   }
+
+   /**
+    * Writes data straight to file, buffer has to be empty
+    *
+    * @return false if data could not be written, a written part is cut off again
+    */
+   bool writeDirect(const char* data, const std::size_t len)
+   {
+      std::size_t done = 0;
+      while(done < len)
+      {
+         const ssize_t n = ::write(_fd, data + done, len - done);
+         if(n < 0)
+         {
+            if(errno == EINTR)
+            {
+               continue;
+            }
+            this->setError("write");
+            if(done && ::ftruncate(_fd, static_cast<off_t>(_length)) != 0)
+            {
+               _error += ", truncate: " + std::string(std::strerror(errno));
+            }
+            return false;
+         }
+         done += static_cast<std::size_t>(n);
+      }
+      _length += len;
+      return true;
+   }
+
+   std::unique_ptr<char, void (*)(void*)> _buf; ///< page aligned write buffer
+   std::size_t _capacity;                       ///< size of _buf
+   std::size_t _used = 0;                       ///< filled bytes of _buf
+   std::string _line;                           ///< reused buffer for one log
+   std::int64_t _failed_at = 0;                 ///< time [ns] of last failed open
 };
 
 } // namespace evo
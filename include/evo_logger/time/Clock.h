@@ -0,0 +1,225 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOCLOCK_H_
+#define EVOCLOCK_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define EVO_CLOCK_HAS_TSC 1
+#else
+#define EVO_CLOCK_HAS_TSC 0
+#endif
+
+namespace evo {
+
+/**
+ * @brief Clock source for timestamps, optionally based on the invariant TSC
+ *
+ * raw() returns a cheap raw timestamp which is converted to nanoseconds since
+ * epoch by toNSec() later, e.g. when the log is written. By default raw() is
+ * the system clock in nanoseconds. After enableTsc() it is the time stamp counter
+ * of the CPU (x86-64 Linux with invariant TSC only), calibrated once against
+ * CLOCK_MONOTONIC (rate) and CLOCK_REALTIME (offset). Raw TSC values are marked
+ * by the highest bit, so values taken before enableTsc() are still converted
+ * correctly.
+ *
+ * @code
+ * if(!evo::Clock::enableTsc())
+ * {
+ *    // not supported, system clock is used
+ * }
+ * @endcode
+ *
+ * @note the TSC is not corrected by NTP after calibration
+ *
+ * @author MSC
+ */
+class Clock
+{
+ public:
+   /**
+    * Gets raw timestamp
+    *
+    * @return TSC ticks (marked) or nanoseconds since epoch
+    */
+   static std::uint64_t raw() noexcept
+   {
+#if EVO_CLOCK_HAS_TSC
+      if(params().enabled.load(std::memory_order_acquire))
+      {
+         return __rdtsc() | TSC_MARK;
+      }
+#endif
+      return static_cast<std::uint64_t>(systemNSec());
+   }
+
+   /**
+    * Converts raw timestamp to nanoseconds since epoch
+    *
+    * @param[in] raw timestamp from raw()
+    * @return nanoseconds since epoch
+    */
+   static std::int64_t toNSec(const std::uint64_t raw) noexcept
+   {
+#if EVO_CLOCK_HAS_TSC
+      if(raw & TSC_MARK)
+      {
+         const Params& p           = params();
+         const std::int64_t delta  = static_cast<std::int64_t>(raw & ~TSC_MARK) -
+                                    static_cast<std::int64_t>(p.base_tsc);
+         const __int128 ns_delta   = (static_cast<__int128>(delta) * p.mult) >> SHIFT;
+         return p.base_ns + static_cast<std::int64_t>(ns_delta);
+      }
+#endif
+      return static_cast<std::int64_t>(raw);
+   }
+
+   /**
+    * Gets current time
+    *
+    * @return nanoseconds since epoch
+    */
+   static std::int64_t nowNSec() noexcept { return toNSec(raw()); }
+
+   /**
+    * Calibrates and enables TSC as clock source, has only on first call an effect
+    *
+    * Takes about 20 ms for calibration. Thread safe, concurrent callers wait for
+    * the calibration, parameters are published once before raw() switches to TSC.
+    *
+    * @return true if TSC is used, false if not supported (system clock is used)
+    */
+   static bool enableTsc()
+   {
+#if EVO_CLOCK_HAS_TSC
+      Params& p = params();
+      if(p.enabled.load(std::memory_order_acquire))
+      {
+         return true;
+      }
+      std::lock_guard<std::mutex> lock(p.mutex);
+      if(p.enabled.load(std::memory_order_relaxed))
+      {
+         return true; // calibrated by other thread meanwhile
+      }
+      if(!invariantTsc())
+      {
+         return false;
+      }
+
+      std::uint64_t tsc0 = 0, tsc1 = 0, base_tsc = 0;
+      std::int64_t mono0 = 0, mono1 = 0, real0 = 0;
+      sample(CLOCK_MONOTONIC, tsc0, mono0);
+      sample(CLOCK_REALTIME, base_tsc, real0);
+      struct timespec wait = {0, 20000000};
+      nanosleep(&wait, nullptr);
+      sample(CLOCK_MONOTONIC, tsc1, mono1);
+      if(tsc1 <= tsc0 || mono1 <= mono0)
+      {
+         return false;
+      }
+
+      const double ns_per_tick =
+          static_cast<double>(mono1 - mono0) / static_cast<double>(tsc1 - tsc0);
+      p.mult     = static_cast<std::int64_t>(ns_per_tick * static_cast<double>(1ll << SHIFT));
+      p.base_tsc = base_tsc;
+      p.base_ns  = real0;
+      p.enabled.store(true, std::memory_order_release);
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   /**
+    * Getter for clock source
+    *
+    * @return true if TSC is used
+    */
+   static bool isTsc() noexcept { return params().enabled.load(std::memory_order_relaxed); }
+
+   /**
+    * Gets system clock
+    *
+    * @return nanoseconds since epoch
+    */
+   static std::int64_t systemNSec() noexcept
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::high_resolution_clock::now().time_since_epoch())
+          .count();
+   }
+
+ private:
+   static const std::uint64_t TSC_MARK = 1ull << 63; ///< marks raw TSC values
+   static const int SHIFT              = 32;         ///< fixed point of mult
+
+   /**
+    * Calibration of TSC
+    */
+   struct Params
+   {
+      std::atomic<bool> enabled{false}; ///< TSC is used by raw()
+      std::uint64_t base_tsc = 0;       ///< TSC at calibration
+      std::int64_t base_ns   = 0;       ///< CLOCK_REALTIME at base_tsc
+      std::int64_t mult      = 0;       ///< ns per tick, fixed point << SHIFT
+      std::mutex mutex;                 ///< serializes enableTsc()
+   };
+
+   static Params& params() noexcept
+   {
+      static Params p;
+      return p;
+   }
+
+#if EVO_CLOCK_HAS_TSC
+   /**
+    * Proves CPUID for invariant TSC (constant rate, not stopped in sleep states)
+    */
+   static bool invariantTsc()
+   {
+      unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+      if(!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007)
+      {
+         return false;
+      }
+      __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+      return edx & (1u << 8);
+   }
+
+   /**
+    * Reads TSC and given clock close together, takes the tightest of some tries
+    */
+   static void sample(const clockid_t id, std::uint64_t& tsc, std::int64_t& ns)
+   {
+      std::uint64_t best = ~0ull;
+      for(int i = 0; i < 8; i++)
+      {
+         struct timespec ts;
+         const std::uint64_t t0 = __rdtsc();
+         clock_gettime(id, &ts);
+         const std::uint64_t t1 = __rdtsc();
+         if(t1 - t0 < best)
+         {
+            best = t1 - t0;
+            tsc  = t0 + (t1 - t0) / 2;
+            ns   = static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+         }
+      }
+   }
+#endif
+};
+
+} // namespace evo
+
+#endif /* EVOCLOCK_H_ */
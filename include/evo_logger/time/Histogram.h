@@ -0,0 +1,267 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOHISTOGRAM_H_
+#define EVOHISTOGRAM_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace evo {
+
+/**
+ * @brief Latency histogram with logarithmic buckets
+ *
+ * Every power of two is split into 4 buckets, so values (e.g. nanoseconds) from 0
+ * to 2^64 fit into 252 buckets with at most 25 % relative error, adding a value is
+ * a few instructions without allocation. Histograms of several threads are
+ * combined with merge().
+ *
+ * @author MSC
+ */
+class Histogram
+{
+ public:
+   static const int BUCKETS = 252; ///< number of buckets
+
+   /**
+    * Adds value
+    *
+    * @param[in] value e.g. duration [ns]
+    */
+   void add(const std::uint64_t value)
+   {
+      _buckets[Histogram::bucket(value)]++;
+      _count++;
+      _sum += value;
+      _min = value < _min ? value : _min;
+      _max = value > _max ? value : _max;
+   }
+
+   /**
+    * Adds all values of other histogram
+    *
+    * @param[in] other histogram
+    */
+   void merge(const Histogram& other)
+   {
+      for(int i = 0; i < BUCKETS; i++)
+      {
+         _buckets[i] += other._buckets[i];
+      }
+      _count += other._count;
+      _sum += other._sum;
+      _min = other._min < _min ? other._min : _min;
+      _max = other._max > _max ? other._max : _max;
+   }
+
+   /**
+    * Getter for value below which given share of the values is
+    *
+    * @param[in] p share, e.g. 0.99
+    * @return middle of bucket containing the percentile, 0 if empty
+    */
+   std::uint64_t percentile(const double p) const
+   {
+      if(!_count)
+      {
+         return 0;
+      }
+      const std::uint64_t rank = static_cast<std::uint64_t>(p * (_count - 1)) + 1;
+      std::uint64_t seen       = 0;
+      for(int i = 0; i < BUCKETS; i++)
+      {
+         seen += _buckets[i];
+         if(seen >= rank)
+         {
+            const std::uint64_t mid = Histogram::lower(i) + Histogram::width(i) / 2;
+            return mid < _max ? mid : _max;
+         }
+      }
+      return _max;
+   }
+
+   std::uint64_t count() const { return _count; }
+
+   std::uint64_t sum() const { return _sum; }
+
+   /**
+    * Getter for smallest value
+    *
+    * @return min, 0 if empty
+    */
+   std::uint64_t min() const { return _count ? _min : 0; }
+
+   std::uint64_t max() const { return _max; }
+
+   /**
+    * Getter for mean value
+    *
+    * @return mean, 0 if empty
+    */
+   double mean() const
+   {
+      return _count ? static_cast<double>(_sum) / static_cast<double>(_count) : 0.0;
+   }
+
+   /**
+    * Getter for number of values in bucket
+    *
+    * @param[in] i bucket, see lower()
+    * @return count
+    */
+   std::uint64_t bucketCount(const int i) const { return _buckets[i]; }
+
+   /**
+    * Getter for bucket of value
+    *
+    * @param[in] value value
+    * @return index of bucket
+    */
+   static int bucket(const std::uint64_t value)
+   {
+      if(value < 4)
+      {
+         return static_cast<int>(value);
+      }
+      const int exp = 63 - __builtin_clzll(value); // >= 2
+      return 4 * (exp - 1) + static_cast<int>((value >> (exp - 2)) & 3);
+   }
+
+   /**
+    * Getter for smallest value of bucket
+    *
+    * @param[in] i index of bucket
+    * @return lower bound
+    */
+   static std::uint64_t lower(const int i)
+   {
+      if(i < 4)
+      {
+         return static_cast<std::uint64_t>(i);
+      }
+      const int exp = i / 4 + 1;
+      return (4ull + static_cast<std::uint64_t>(i % 4)) << (exp - 2);
+   }
+
+   /**
+    * Getter for number of values of bucket
+    *
+    * @param[in] i index of bucket
+    * @return width
+    */
+   static std::uint64_t width(const int i)
+   {
+      return i < 4 ? 1 : 1ull << (i / 4 - 1);
+   }
+
+   /**
+    * Formats nanoseconds with unit, e.g. "350 ns", "1.2 us", "15.0 ms"
+    *
+    * @param[in] ns duration [ns]
+    * @return formatted duration
+    */
+   static std::string formatNs(const double ns)
+   {
+      char buf[32];
+      if(ns < 1e3)
+      {
+         std::snprintf(buf, sizeof(buf), "%.0f ns", ns);
+      }
+      else if(ns < 1e6)
+      {
+         std::snprintf(buf, sizeof(buf), "%.1f us", ns * 1e-3);
+      }
+      else if(ns < 1e9)
+      {
+         std::snprintf(buf, sizeof(buf), "%.1f ms", ns * 1e-6);
+      }
+      else
+      {
+         std::snprintf(buf, sizeof(buf), "%.2f s", ns * 1e-9);
+      }
+      return buf;
+   }
+
+ private:
+   friend class SharedHistogram;
+
+   std::uint64_t _buckets[BUCKETS] = {};    ///< values per bucket
+   std::uint64_t _count            = 0;     ///< number of values
+   std::uint64_t _sum              = 0;     ///< sum of values
+   std::uint64_t _min              = ~0ull; ///< smallest value
+   std::uint64_t _max              = 0;     ///< largest value
+};
+
+/**
+ * @brief Histogram written by one thread and read by others, see Histogram
+ *
+ * Values are relaxed atomics written with load and store (no locked
+ * instructions), snapshots taken by other threads may mix values of consecutive
+ * add() calls but never tear a value.
+ *
+ * @author MSC
+ */
+class SharedHistogram
+{
+ public:
+   /**
+    * Adds value, only called by the owning thread
+    *
+    * @param[in] value e.g. duration [ns]
+    */
+   void add(const std::uint64_t value)
+   {
+      SharedHistogram::inc(_buckets[Histogram::bucket(value)], 1);
+      SharedHistogram::inc(_count, 1);
+      SharedHistogram::inc(_sum, value);
+      if(value < _min.load(std::memory_order_relaxed))
+      {
+         _min.store(value, std::memory_order_relaxed);
+      }
+      if(value > _max.load(std::memory_order_relaxed))
+      {
+         _max.store(value, std::memory_order_relaxed);
+      }
+   }
+
+   /**
+    * Adds current values to given histogram
+    *
+    * @param[in, out] out histogram
+    */
+   void collect(Histogram& out) const
+   {
+      for(int i = 0; i < Histogram::BUCKETS; i++)
+      {
+         out._buckets[i] += _buckets[i].load(std::memory_order_relaxed);
+      }
+      out._count += _count.load(std::memory_order_relaxed);
+      out._sum += _sum.load(std::memory_order_relaxed);
+      const std::uint64_t min = _min.load(std::memory_order_relaxed);
+      out._min                = min < out._min ? min : out._min;
+      const std::uint64_t max = _max.load(std::memory_order_relaxed);
+      out._max                = max > out._max ? max : out._max;
+   }
+
+ private:
+   static void inc(std::atomic<std::uint64_t>& value, const std::uint64_t n)
+   {
+      value.store(value.load(std::memory_order_relaxed) + n,
+                  std::memory_order_relaxed);
+   }
+
+   std::atomic<std::uint64_t> _buckets[Histogram::BUCKETS] = {}; ///< per bucket
+   std::atomic<std::uint64_t> _count{0};   ///< number of values
+   std::atomic<std::uint64_t> _sum{0};     ///< sum of values
+   std::atomic<std::uint64_t> _min{~0ull}; ///< smallest value
+   std::atomic<std::uint64_t> _max{0};     ///< largest value
+};
+
+} // namespace evo
+
+#endif /* EVOHISTOGRAM_H_ */
@@ -0,0 +1,478 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOPROFILER_H_
+#define EVOPROFILER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "evo_logger/base/ThreadRegistry.h"
+#include "evo_logger/log/Logger.h"
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/Histogram.h"
+
+namespace evo {
+
+/**
+ * Scope in the call tree of one thread, time is written by the thread only
+ */
+struct ProfileNode
+{
+   ProfileNode(const char* n, ProfileNode* p) : name(n), parent(p) {}
+
+   const char* name;     ///< name of scope, string with static lifetime
+   ProfileNode* parent;  ///< enclosing scope, nullptr for root of tree
+   SharedHistogram time; ///< [ns] per call
+
+   /// nested scopes, appended by the thread under ProfileTree::mutex
+   std::vector<std::unique_ptr<ProfileNode>> children;
+};
+
+/**
+ * Call tree of one thread
+ */
+struct ProfileTree
+{
+   ProfileTree() : root("", nullptr), current(&root) {}
+
+   std::mutex mutex;     ///< serializes new nodes and reports
+   ProfileNode root;     ///< root, no scope
+   ProfileNode* current; ///< innermost open scope, used by the thread only
+};
+
+/**
+ * @brief Call tree of all threads merged by name, see Profiler::report()
+ *
+ * @author MSC
+ */
+class ProfileReport
+{
+ public:
+   /**
+    * Scope of merged call tree
+    */
+   struct Node
+   {
+      std::string name;           ///< name of scope
+      Histogram time;             ///< [ns] per call
+      std::vector<Node> children; ///< nested scopes in order of first call
+
+      /**
+       * Getter for nested scope, creates it if missing
+       *
+       * @param[in] child name of nested scope
+       * @return nested scope
+       */
+      Node& child(const std::string& child)
+      {
+         for(Node& node : children)
+         {
+            if(node.name == child)
+            {
+               return node;
+            }
+         }
+         children.push_back(Node());
+         children.back().name = child;
+         return children.back();
+      }
+   };
+
+   Node root;            ///< root, its children are the outermost scopes
+   double elapsed = 0.0; ///< [s] since first scope
+
+   /**
+    * Finds scope by path of names separated by '/', e.g. "loop/read"
+    *
+    * @param[in] path names from outermost scope
+    * @return scope, nullptr if not found
+    */
+   const Node* find(const std::string& path) const
+   {
+      const Node* node  = &root;
+      std::size_t start = 0;
+      while(node && start <= path.size())
+      {
+         std::size_t end = path.find('/', start);
+         end             = end == std::string::npos ? path.size() : end;
+         const std::string name = path.substr(start, end - start);
+         const Node* next       = nullptr;
+         for(const Node& child : node->children)
+         {
+            if(child.name == name)
+            {
+               next = &child;
+               break;
+            }
+         }
+         node  = next;
+         start = end + 1;
+      }
+      return node;
+   }
+
+   /**
+    * Formats report as table, one line per scope, nested scopes indented
+    *
+    * Column share is the total time of a scope relative to the total time of its
+    * parent, for outermost scopes relative to elapsed (sum of all threads, may
+    * exceed 100 %).
+    *
+    * @return report
+    */
+   std::string toString() const
+   {
+      char line[256];
+      std::snprintf(line, sizeof(line),
+                    "profile of %.1f s\n%-32s %10s %9s %9s %9s %9s %9s %9s %6s",
+                    elapsed, "scope", "calls", "mean", "min", "p50", "p99", "max",
+                    "total", "share");
+      std::string out = line;
+      for(const Node& node : root.children)
+      {
+         ProfileReport::print(out, node, 0, elapsed * 1e9);
+      }
+      return out;
+   }
+
+ private:
+   static void print(std::string& out, const Node& node, const int depth,
+                     const double parent_ns)
+   {
+      const std::string name = std::string(2 * depth, ' ') + node.name;
+      const double total     = static_cast<double>(node.time.sum());
+      char line[256];
+      std::snprintf(
+          line, sizeof(line), "\n%-32s %10llu %9s %9s %9s %9s %9s %9s %5.1f%%",
+          name.c_str(), static_cast<unsigned long long>(node.time.count()),
+          Histogram::formatNs(node.time.mean()).c_str(),
+          ProfileReport::ns(node.time.min()).c_str(),
+          ProfileReport::ns(node.time.percentile(0.5)).c_str(),
+          ProfileReport::ns(node.time.percentile(0.99)).c_str(),
+          ProfileReport::ns(node.time.max()).c_str(),
+          Histogram::formatNs(total).c_str(),
+          parent_ns > 0.0 ? 100.0 * total / parent_ns : 0.0);
+      out += line;
+      for(const Node& child : node.children)
+      {
+         ProfileReport::print(out, child, depth + 1, total);
+      }
+   }
+
+   static std::string ns(const std::uint64_t value)
+   {
+      return Histogram::formatNs(static_cast<double>(value));
+   }
+};
+
+/**
+ * @brief Aggregating profiler of named scopes, see ProfileScope
+ *
+ * Every thread keeps its own call tree: a scope opened inside another scope is
+ * its child, so the same name may appear at several places of the tree. Each
+ * scope accumulates count, min, max, mean and a latency Histogram of its calls,
+ * without locks (a mutex of the thread is only taken when a scope is called the
+ * first time at a place of the tree). report() merges the trees of all threads,
+ * also of threads that have ended. Nothing is logged per call, so scopes can stay
+ * in control loops in production.
+ *
+ * @code
+ * evo::Profiler::setDumpInterval(60.0); // log report every 60 s
+ * while(running)
+ * {
+ *    EVO_PROFILE("loop");
+ *    {
+ *       EVO_PROFILE("read");
+ *       read();
+ *    }
+ *    compute();
+ * }
+ * std::cout << evo::Profiler::report().toString() << std::endl;
+ * @endcode
+ *
+ * Enabled by default, a disabled profiler costs one relaxed load per scope.
+ *
+ * @author MSC
+ */
+class Profiler
+{
+ public:
+   /**
+    * Proves if scopes are measured
+    *
+    * @return true if enabled
+    */
+   static bool enabled() { return Profiler::flag().load(std::memory_order_relaxed); }
+
+   /**
+    * Enables or disables measurement, values are kept
+    *
+    * @param[in] enable true to measure
+    */
+   static void setEnabled(const bool enable)
+   {
+      Profiler::flag().store(enable, std::memory_order_relaxed);
+   }
+
+   /**
+    * Setter for periodic report, logged at INFO level when an outermost scope
+    * ends after the interval
+    *
+    * @param[in] interval [s] between reports, 0 disables them
+    */
+   static void setDumpInterval(const double interval)
+   {
+      const std::int64_t ns = static_cast<std::int64_t>(interval * 1e9);
+      Dump& dump            = Profiler::dump();
+      dump.next.store(Clock::nowNSec() + ns, std::memory_order_relaxed);
+      dump.interval.store(ns > 0 ? ns : 0, std::memory_order_relaxed);
+   }
+
+   /**
+    * Merges call trees of all threads
+    *
+    * @return report, values are totals since the first scope
+    */
+   static ProfileReport report()
+   {
+      ProfileReport out;
+      Trees::visit(
+          [&out](const Ended& ended, const std::vector<ProfileTree*>& trees) {
+             Profiler::merge(out.root, ended.root);
+             for(ProfileTree* tree : trees)
+             {
+                std::lock_guard<std::mutex> tree_lock(tree->mutex);
+                Profiler::merge(out.root, tree->root);
+             }
+             if(ended.start)
+             {
+                out.elapsed =
+                    static_cast<double>(Clock::nowNSec() - ended.start) * 1e-9;
+             }
+          });
+      return out;
+   }
+
+   /**
+    * Opens scope in call tree of calling thread, see ProfileScope
+    *
+    * @param[in] name name of scope, string with static lifetime
+    * @return scope, nullptr if disabled
+    */
+   static ProfileNode* enter(const char* name) noexcept
+   {
+      if(!Profiler::enabled())
+      {
+         return nullptr;
+      }
+      ProfileTree* tree = Trees::local();
+      if(!tree)
+      {
+         return nullptr;
+      }
+      ProfileNode* node = Profiler::child(*tree, *tree->current, name);
+      if(node)
+      {
+         tree->current = node;
+      }
+      return node;
+   }
+
+   /**
+    * Closes scope opened by enter() and adds its duration
+    *
+    * @param[in] node  scope returned by enter()
+    * @param[in] start raw timestamp of start of scope (see Clock)
+    */
+   static void leave(ProfileNode* node, const std::uint64_t start) noexcept
+   {
+      const std::int64_t end = Clock::nowNSec();
+      const std::int64_t ns  = end - Clock::toNSec(start);
+      node->time.add(ns > 0 ? static_cast<std::uint64_t>(ns) : 0);
+      ProfileTree* tree = Trees::local();
+      if(tree)
+      {
+         tree->current = node->parent;
+      }
+      if(!node->parent->parent)
+      {
+         Profiler::dumpIfDue(end);
+      }
+   }
+
+ private:
+   /**
+    * Merged trees of ended threads and start of profiling
+    */
+   struct Ended
+   {
+      ProfileReport::Node root; ///< merged trees of ended threads
+      std::int64_t start = 0;   ///< time [ns] of first scope
+
+      void attach(ProfileTree&)
+      {
+         if(!start)
+         {
+            start = Clock::nowNSec();
+         }
+      }
+
+      void retire(const ProfileTree& tree) { Profiler::merge(root, tree.root); }
+   };
+
+   using Trees = ThreadRegistry<ProfileTree, Ended>; ///< call trees of all threads
+
+   /**
+    * State of periodic report
+    */
+   struct Dump
+   {
+      std::atomic<std::int64_t> interval{0}; ///< [ns] between reports
+      std::atomic<std::int64_t> next{0};     ///< time [ns] of next report
+   };
+
+   /**
+    * Finds or creates nested scope
+    */
+   static ProfileNode* child(ProfileTree& tree, ProfileNode& parent,
+                             const char* name) noexcept
+   {
+      for(const std::unique_ptr<ProfileNode>& node : parent.children)
+      {
+         if(node->name == name)
+         {
+            return node.get();
+         }
+      }
+      for(const std::unique_ptr<ProfileNode>& node : parent.children)
+      {
+         if(std::strcmp(node->name, name) == 0) // literal of other translation unit
+         {
+            return node.get();
+         }
+      }
+      try
+      {
+         std::unique_ptr<ProfileNode> node(new ProfileNode(name, &parent));
+         std::lock_guard<std::mutex> lock(tree.mutex);
+         parent.children.push_back(std::move(node));
+         return parent.children.back().get();
+      } catch(std::bad_alloc& e)
+      {
+         return nullptr;
+      }
+   }
+
+   /**
+    * Logs report if dump interval elapsed, one thread wins per interval
+    */
+   static void dumpIfDue(const std::int64_t now) noexcept
+   {
+      Dump& dump                  = Profiler::dump();
+      const std::int64_t interval = dump.interval.load(std::memory_order_relaxed);
+      std::int64_t next           = dump.next.load(std::memory_order_relaxed);
+      if(interval <= 0 || now < next ||
+         !dump.next.compare_exchange_strong(next, now + interval,
+                                            std::memory_order_relaxed))
+      {
+         return;
+      }
+      try
+      {
+         log::info(Profiler::report().toString());
+      } catch(std::bad_alloc& e)
+      {
+      }
+   }
+
+   static void merge(ProfileReport::Node& out, const ProfileNode& in)
+   {
+      in.time.collect(out.time);
+      for(const std::unique_ptr<ProfileNode>& child : in.children)
+      {
+         Profiler::merge(out.child(child->name), *child);
+      }
+   }
+
+   static void merge(ProfileReport::Node& out, const ProfileReport::Node& in)
+   {
+      out.time.merge(in.time);
+      for(const ProfileReport::Node& child : in.children)
+      {
+         Profiler::merge(out.child(child.name), child);
+      }
+   }
+
+   static Dump& dump()
+   {
+      static Dump dump;
+      return dump;
+   }
+
+   static std::atomic<bool>& flag()
+   {
+      static std::atomic<bool> flag(true);
+      return flag;
+   }
+};
+
+/**
+ * @brief Measures a named scope with the Profiler until destruction
+ *
+ * Unlike TimerAuto_ms nothing is logged per call, durations are accumulated per
+ * scope and thread (see Profiler). Use EVO_PROFILE(name) for an anonymous scope
+ * object.
+ *
+ * @author MSC
+ */
+class ProfileScope
+{
+ public:
+   /**
+    * Constructor opens scope
+    *
+    * @param[in] name name of scope, string with static lifetime (e.g. literal)
+    */
+   explicit ProfileScope(const char* name) noexcept
+       : _node(Profiler::enter(name)), _start(_node ? Clock::raw() : 0)
+   {
+   }
+
+   ProfileScope(const ProfileScope&) = delete;
+   ProfileScope& operator=(const ProfileScope&) = delete;
+
+   /**
+    * Destructor closes scope and adds its duration
+    */
+   ~ProfileScope()
+   {
+      if(_node)
+      {
+         Profiler::leave(_node, _start);
+      }
+   }
+
+ private:
+   ProfileNode* _node;   ///< scope, nullptr if profiler is disabled
+   std::uint64_t _start; ///< raw timestamp of start (see Clock)
+};
+
+} // namespace evo
+
+#define EVO_PROFILE_CONCAT_(a, b) a##b
+#define EVO_PROFILE_VAR_(line) EVO_PROFILE_CONCAT_(evo_profile_scope_, line)
+
+/// measures rest of enclosing block as scope name (see ProfileScope)
+#define EVO_PROFILE(name) ::evo::ProfileScope EVO_PROFILE_VAR_(__LINE__)(name)
+
+#endif /* EVOPROFILER_H_ */
@@ -13,10 +13,14 @@
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstdint>
 #include <ctime>
 
 #include <thread> //for cross platform sleep
 
+#include "evo_logger/time/Clock.h"
+#include "evo_logger/time/TimeFormatter.h"
+
 namespace evo {
 
 using DurationType = std::chrono::duration<double>;
@@ -207,32 +211,36 @@ class Time
 {
  public: // static
    /**
-    * Get current system time
+    * Get current system time, from TSC if enabled (see Clock::enableTsc())
     *
     * @return current time as evo::Time
     */
-   static Time now() noexcept
+   static Time now() noexcept { return Time::fromNSec(Clock::nowNSec()); }
+
+   /**
+    * Creates time point from nanoseconds since epoch
+    *
+    * @param[in] ns nanoseconds since epoch
+    * @return time as evo::Time
+    */
+   static Time fromNSec(const std::int64_t ns) noexcept
    {
-      return Time(std::chrono::high_resolution_clock::now());
+      return Time(TimePoint(DurationType(static_cast<double>(ns) * 1e-9)));
    }
 
    /**
-    * Converts std::chrono::time_point to std::string
+    * Converts std::chrono::time_point to std::string (second resolution, see
+    * TimeFormatter for sub-second digits)
     *
     * @param[in] t time point to convert
     * @return date+time as std::string
     */
    static std::string toString(TimePoint t) noexcept
    {
-      std::time_t tt = std::chrono::high_resolution_clock::to_time_t(
-          std::chrono::high_resolution_clock::time_point(
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  t.time_since_epoch())));
-
-      std::stringstream sstr;
-      char cstr[64];
-      std::strftime(cstr, sizeof(cstr), "%Y%m%d_%H-%M-%S", std::localtime(&tt));
-      return cstr;
+      return TimeFormatter::toString(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch())
+              .count(),
+          TimeFormatter::SEC);
    }
 
    /**
@@ -300,6 +308,18 @@ class Time
       return tmp.toSec();
    }
 
+   /**
+    * Converts time point to nanoseconds since epoch (rounded down)
+    *
+    * @return time point as nanoseconds
+    */
+   std::int64_t toNSec() const noexcept
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 _timepoint.time_since_epoch())
+          .count();
+   }
+
    Time& operator=(const Time& t) = default;
 
    Time& operator=(Time&& t) = default;
@@ -0,0 +1,292 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+#ifndef EVOTIMEFORMATTER_H_
+#define EVOTIMEFORMATTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+namespace evo {
+
+/**
+ * @brief Thread safe timestamp formatter with cached date/time prefix
+ *
+ * Formats nanoseconds since epoch as local time "YYYYmmdd_HH-MM-SS" followed by
+ * the sub-second digits of the configured precision (e.g. ".123" for MSEC). The
+ * prefix is computed with localtime_r only once per second and thread, every
+ * other call only writes the sub-second digits.
+ *
+ * @code
+ * evo::TimeFormatter::setPrecision(evo::TimeFormatter::USEC);
+ * @endcode
+ *
+ * @author MSC
+ */
+class TimeFormatter
+{
+ public:
+   /**
+    * Number of sub-second digits
+    */
+   enum Precision : int
+   {
+      SEC  = 0, ///< no sub-second digits
+      MSEC = 3, ///< milliseconds
+      USEC = 6, ///< microseconds
+      NSEC = 9  ///< nanoseconds
+   };
+
+   static const std::size_t MAX_LENGTH = 27; ///< max length of formatted time
+
+   /**
+    * Setter for precision used for log output
+    *
+    * @param[in] precision number of sub-second digits
+    */
+   static void setPrecision(const Precision precision)
+   {
+      precisionRef().store(precision, std::memory_order_relaxed);
+   }
+
+   /**
+    * Getter for precision used for log output
+    *
+    * @return number of sub-second digits
+    */
+   static Precision getPrecision()
+   {
+      return static_cast<Precision>(precisionRef().load(std::memory_order_relaxed));
+   }
+
+   /**
+    * Formats timestamp into given buffer, not null terminated
+    *
+    * @param[out] buf       buffer with at least MAX_LENGTH chars
+    * @param[in]  ns        nanoseconds since epoch
+    * @param[in]  precision number of sub-second digits
+    * @return number of chars written
+    */
+   static std::size_t format(char* buf, const std::int64_t ns, const Precision precision)
+   {
+      std::int64_t sec = ns / 1000000000;
+      std::int64_t sub = ns % 1000000000;
+      if(sub < 0)
+      {
+         sec--;
+         sub += 1000000000;
+      }
+
+      Cache& cache = cacheRef();
+      if(!cache.valid || cache.sec != sec)
+      {
+         std::time_t tt = static_cast<std::time_t>(sec);
+         std::tm tm;
+         if(localtime_r(&tt, &tm) &&
+            std::strftime(cache.prefix, sizeof(cache.prefix), "%Y%m%d_%H-%M-%S", &tm))
+         {
+            cache.len = std::strlen(cache.prefix);
+         }
+         else
+         {
+            cache.len = 0;
+         }
+         cache.sec   = sec;
+         cache.valid = true;
+      }
+
+      std::memcpy(buf, cache.prefix, cache.len);
+      std::size_t len = cache.len;
+      if(precision > 0)
+      {
+         buf[len++] = '.';
+         // drop digits below precision
+         for(int i = precision; i < 9; i++)
+         {
+            sub /= 10;
+         }
+         for(int i = precision - 1; i >= 0; i--)
+         {
+            buf[len + static_cast<std::size_t>(i)] = static_cast<char>('0' + sub % 10);
+            sub /= 10;
+         }
+         len += static_cast<std::size_t>(precision);
+      }
+      return len;
+   }
+
+   /**
+    * Appends formatted timestamp to string
+    *
+    * @param[out] str       string to append to
+    * @param[in]  ns        nanoseconds since epoch
+    * @param[in]  precision number of sub-second digits
+    */
+   static void append(std::string& str, const std::int64_t ns,
+                      const Precision precision = getPrecision())
+   {
+      char buf[MAX_LENGTH];
+      str.append(buf, format(buf, ns, precision));
+   }
+
+   /**
+    * Formats timestamp to string
+    *
+    * @param[in] ns        nanoseconds since epoch
+    * @param[in] precision number of sub-second digits
+    * @return formatted time
+    */
+   static std::string toString(const std::int64_t ns,
+                               const Precision precision = getPrecision())
+   {
+      char buf[MAX_LENGTH];
+      return std::string(buf, format(buf, ns, precision));
+   }
+
+   /**
+    * Drops the sub-second digits below precision, like format() does
+    *
+    * @param[in] ns        nanoseconds since epoch
+    * @param[in] precision number of sub-second digits
+    * @return timestamp as parsed back from the formatted time
+    */
+   static std::int64_t truncate(const std::int64_t ns,
+                                const Precision precision = getPrecision())
+   {
+      std::int64_t unit = 1;
+      for(int i = precision; i < 9; i++)
+      {
+         unit *= 10;
+      }
+      const std::int64_t rest = ns % unit;
+      return ns - (rest < 0 ? rest + unit : rest);
+   }
+
+   /**
+    * Parses timestamp in the format written by format() as local time, used to
+    * read log files
+    *
+    * @param[in]  str pointer to formatted time, not null terminated
+    * @param[in]  len number of available chars
+    * @param[out] ns  nanoseconds since epoch
+    * @return number of chars parsed, 0 if str does not start with a timestamp
+    */
+   static std::size_t parse(const char* str, const std::size_t len, std::int64_t& ns)
+   {
+      static const std::size_t digits[] = {0,  1,  2,  3,  4,  5,  6,
+                                           7,  9,  10, 12, 13, 15, 16};
+      if(len < 17 || str[8] != '_' || str[11] != '-' || str[14] != '-')
+      {
+         return 0;
+      }
+      for(const std::size_t i : digits)
+      {
+         if(str[i] < '0' || str[i] > '9')
+         {
+            return 0;
+         }
+      }
+
+      // mktime only once per hour and thread
+      ParseCache& cache = parseCacheRef();
+      if(!cache.valid || std::memcmp(cache.hour, str, sizeof(cache.hour)) != 0)
+      {
+         std::tm tm  = std::tm();
+         tm.tm_year  = TimeFormatter::number(str, 4) - 1900;
+         tm.tm_mon   = TimeFormatter::number(str + 4, 2) - 1;
+         tm.tm_mday  = TimeFormatter::number(str + 6, 2);
+         tm.tm_hour  = TimeFormatter::number(str + 9, 2);
+         tm.tm_isdst = -1;
+         const std::time_t tt = std::mktime(&tm);
+         if(tt == static_cast<std::time_t>(-1))
+         {
+            return 0;
+         }
+         std::memcpy(cache.hour, str, sizeof(cache.hour));
+         cache.sec   = static_cast<std::int64_t>(tt);
+         cache.valid = true;
+      }
+      const std::int64_t sec = cache.sec + TimeFormatter::number(str + 12, 2) * 60 +
+                               TimeFormatter::number(str + 15, 2);
+
+      std::size_t pos  = 17;
+      std::int64_t sub = 0;
+      if(pos < len && str[pos] == '.')
+      {
+         int count = 0;
+         for(pos++; pos < len && str[pos] >= '0' && str[pos] <= '9'; pos++)
+         {
+            if(count < 9)
+            {
+               sub = sub * 10 + (str[pos] - '0');
+               count++;
+            }
+         }
+         for(; count < 9; count++)
+         {
+            sub *= 10;
+         }
+      }
+      ns = sec * 1000000000 + sub;
+      return pos;
+   }
+
+ private:
+   /**
+    * Per-thread prefix of the last formatted second
+    */
+   struct Cache
+   {
+      bool valid = false;  ///< prefix was computed
+      std::int64_t sec = 0; ///< second of prefix
+      char prefix[20];     ///< "YYYYmmdd_HH-MM-SS"
+      std::size_t len = 0; ///< length of prefix
+   };
+
+   /**
+    * Per-thread start of the last parsed hour
+    */
+   struct ParseCache
+   {
+      bool valid = false;   ///< sec was computed
+      char hour[11];        ///< "YYYYmmdd_HH"
+      std::int64_t sec = 0; ///< seconds since epoch of hour
+   };
+
+   static int number(const char* str, const int count)
+   {
+      int value = 0;
+      for(int i = 0; i < count; i++)
+      {
+         value = value * 10 + (str[i] - '0');
+      }
+      return value;
+   }
+
+   static ParseCache& parseCacheRef()
+   {
+      thread_local ParseCache cache;
+      return cache;
+   }
+
+   static Cache& cacheRef()
+   {
+      thread_local Cache cache;
+      return cache;
+   }
+
+   static std::atomic<int>& precisionRef()
+   {
+      static std::atomic<int> precision(MSEC);
+      return precision;
+   }
+};
+
+} // namespace evo
+
+#endif /* EVOTIMEFORMATTER_H_ */
@@ -51,6 +51,9 @@ class Timer
 /**
  * TimerAuto class logs info (given msg + Duration as [ms]) when Destructor is called
  *
+ * Logs every call, for scopes in loops use ProfileScope (see Profiler.h), which
+ * accumulates durations without logging.
+ *
  * @author MSC
  */
 class TimerAuto_ms : public Timer
@@ -85,6 +88,9 @@ class TimerAuto_ms : public Timer
 /**
  * TimerAuto class logs info (given msg + Duration as [us]) when Destructor is called
  *
+ * Logs every call, for scopes in loops use ProfileScope (see Profiler.h), which
+ * accumulates durations without logging.
+ *
  * @author MSC
  */
 class TimerAuto_us : public Timer
@@ -0,0 +1,676 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * Benchmarks the hot paths of the logger at 1 to N threads (doubling), every case
+ * reports the latency distribution per call and the throughput of all threads.
+ * Latency samples are the mean of a batch of calls (column batch), so calls
+ * faster than the clock are measured too. Results are written as CSV or JSON,
+ * --compare checks them against a previous CSV result and fails on regressions.
+ *
+ * Logs go to the log file only (terminal disabled), the log file is rotated every
+ * 64 MiB and at most 2 files are kept, so large runs do not fill the disk.
+ *
+ * usage: evo_log_bench [options]
+ *   --threads N      maximum number of threads (default 4)
+ *   --calls N        calls per thread and case (default 100000)
+ *   --filter NAME    only cases containing NAME
+ *   --format F       csv or json (default csv)
+ *   --output FILE    write results to FILE instead of stdout
+ *   --async          enable asynchronous mode of the logger
+ *   --stats          enable self-instrumentation of the logger (see LogStats),
+ *                    prints its summary to stderr
+ *   --compare FILE   compare with CSV result, exit 2 if p50 or throughput of a
+ *                    case is worse by more than --tolerance
+ *   --tolerance P    allowed regression in percent (default 10)
+ *
+ * Build with CMAKE_BUILD_TYPE=Release, the build type is part of the results.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "evo_logger/log/Encoder.h"
+#include "evo_logger/log/Logger.h"
+#include "evo_logger/log/Writer.h"
+#include "evo_logger/time/Profiler.h"
+#include "evo_logger/time/Time.h"
+#include "evo_logger/time/Timer.h"
+
+namespace {
+
+/**
+ * Command line options
+ */
+struct Options
+{
+   unsigned int threads = 4;      ///< maximum number of threads
+   std::uint64_t calls  = 100000; ///< calls per thread and case
+   std::string filter;            ///< substring of case names
+   bool json = false;             ///< JSON instead of CSV
+   std::string output;            ///< output file, empty for stdout
+   bool async = false;            ///< asynchronous logger
+   bool stats = false;            ///< self-instrumentation of logger
+   std::string compare;           ///< CSV result to compare with
+   double tolerance = 10.0;       ///< allowed regression [%]
+};
+
+/**
+ * Result of one case at one number of threads
+ */
+struct Result
+{
+   std::string name;      ///< case
+   unsigned int threads;  ///< number of threads
+   std::uint64_t calls;   ///< calls of all threads
+   unsigned int batch;    ///< calls per latency sample
+   double min, mean, p50; ///< latency per call [ns]
+   double p90, p99, p999; ///< latency per call [ns]
+   double max;            ///< latency per call [ns]
+   double ops;            ///< calls per second of all threads
+};
+
+using Samples = std::vector<double>; ///< latency per call [ns] of each batch
+
+/**
+ * Times f(i) in batches of given size, appends the mean latency of each batch
+ */
+template<typename F>
+void measure(Samples& samples, const std::uint64_t calls, const unsigned int batch,
+             F f)
+{
+   samples.reserve(samples.size() + calls / batch + 1);
+   for(std::uint64_t i = 0; i < calls;)
+   {
+      const std::uint64_t end = std::min(calls, i + batch);
+      const auto start        = std::chrono::steady_clock::now();
+      for(std::uint64_t n = i; n < end; n++)
+      {
+         f(n);
+      }
+      const std::chrono::duration<double, std::nano> took =
+          std::chrono::steady_clock::now() - start;
+      samples.push_back(took.count() / static_cast<double>(end - i));
+      i = end;
+   }
+}
+
+// --- cases, each called by every thread with its number of calls --------------
+
+void infoCstr(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch,
+           [](std::uint64_t) { evo::log::info("benchmark message"); });
+}
+
+void infoPrintf(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      evo::log::info("value %d of %s at %.3f", static_cast<int>(i), "bench",
+                     0.5 * static_cast<double>(i));
+   });
+}
+
+void infoStream(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      evo::log::get() << "value " << i << " of bench" << evo::info;
+   });
+}
+
+void infoFields(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      evo::log::info("benchmark message", {{"id", i}, {"ok", true}});
+   });
+}
+
+void debugDisabled(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      evo::log::debug("value %d of %s", static_cast<int>(i), "bench");
+   });
+}
+
+void timeNow(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t) {
+      const evo::Time t = evo::Time::now();
+      asm volatile("" : : "g"(&t) : "memory"); // keep call
+   });
+}
+
+void timeToString(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   const evo::Time t = evo::Time::now();
+   measure(s, calls, batch, [&t](std::uint64_t i) {
+      const evo::Duration d{std::chrono::nanoseconds(i)};
+      const std::string str = evo::Time::toString(t + d);
+      asm volatile("" : : "g"(str.data()) : "memory");
+   });
+}
+
+void timerAutoUs(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch,
+           [](std::uint64_t) { evo::TimerAuto_us timer("bench: "); });
+}
+
+void profileScope(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t) { EVO_PROFILE("bench"); });
+}
+
+/**
+ * Formats printf-style like log::printfToString() did before Format, reference
+ * for the format_* cases
+ */
+template<typename... Args>
+std::string snprintfToString(const char* str, Args... args)
+{
+   std::size_t size = std::snprintf(nullptr, 0, str, args...) + 1; // +1 for '\0'
+   std::unique_ptr<char[]> buffer(new char[size]);
+   std::snprintf(buffer.get(), size, str, args...);
+   return std::string(buffer.get(), buffer.get() + size - 1); // without '\0'
+}
+
+void keep(const std::string& str)
+{
+   asm volatile("" : : "g"(str.data()) : "memory"); // keep formatting
+}
+
+void formatInt(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      keep(evo::Format::toString("id %d of %u, mask %08x", static_cast<int>(i),
+                                 static_cast<unsigned int>(i >> 4),
+                                 static_cast<unsigned int>(i * 2654435761u)));
+   });
+}
+
+void formatIntSnprintf(Samples& s, const std::uint64_t calls,
+                       const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      keep(snprintfToString("id %d of %u, mask %08x", static_cast<int>(i),
+                            static_cast<unsigned int>(i >> 4),
+                            static_cast<unsigned int>(i * 2654435761u)));
+   });
+}
+
+void formatFloat(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      const double x = 0.5 * static_cast<double>(i);
+      keep(evo::Format::toString("x %.3f y %g z %e", x, x * 1e-3, x * 1e6));
+   });
+}
+
+void formatFloatSnprintf(Samples& s, const std::uint64_t calls,
+                         const unsigned int batch)
+{
+   measure(s, calls, batch, [](std::uint64_t i) {
+      const double x = 0.5 * static_cast<double>(i);
+      keep(snprintfToString("x %.3f y %g z %e", x, x * 1e-3, x * 1e6));
+   });
+}
+
+void formatString(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   const std::string name = "benchmark";
+   measure(s, calls, batch, [&name](std::uint64_t) {
+      keep(evo::Format::toString("%s of %-12s in %.4s", "value", name.c_str(),
+                                 "module"));
+   });
+}
+
+void formatStringSnprintf(Samples& s, const std::uint64_t calls,
+                          const unsigned int batch)
+{
+   const std::string name = "benchmark";
+   measure(s, calls, batch, [&name](std::uint64_t) {
+      keep(snprintfToString("%s of %-12s in %.4s", "value", name.c_str(), "module"));
+   });
+}
+
+/**
+ * Structured log payload of 4 fields appended as logfmt, as done for terminal and
+ * log file, paired with encodePrintf4
+ */
+void encodeFields4(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   const std::string host = "sensor-head-01";
+   evo::FormatBuffer buf;
+   measure(s, calls, batch, [&](std::uint64_t i) {
+      const std::initializer_list<evo::Field> fields = {
+          {"host", host},
+          {"port", static_cast<int>(i & 0xffff)},
+          {"load", 0.25 * static_cast<double>(i & 0xff)},
+          {"took", std::chrono::microseconds(i & 0xfff)}};
+      buf.clear();
+      buf.append("connected", 9);
+      evo::Encoder::appendFields(buf, fields.begin(), fields.size());
+      asm volatile("" : : "g"(buf.data()) : "memory");
+   });
+}
+
+/**
+ * Same payload as encodeFields4 formatted like log::printfToString()
+ */
+void encodePrintf4(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   const std::string host = "sensor-head-01";
+   measure(s, calls, batch, [&](std::uint64_t i) {
+      keep(evo::Format::toString("connected host=%s port=%d load=%g took=%lluus",
+                                 host.c_str(), static_cast<int>(i & 0xffff),
+                                 0.25 * static_cast<double>(i & 0xff),
+                                 static_cast<unsigned long long>(i & 0xfff)));
+   });
+}
+
+/**
+ * Writer::write() of calls records into an own file, in stores of batch records,
+ * filling the stores is not timed
+ */
+void writerWrite(Samples& s, const std::uint64_t calls, const unsigned int batch)
+{
+   static std::atomic<int> id(0);
+   const std::string file =
+       "/tmp/evo_log_bench_" + std::to_string(::getpid()) + "_" +
+       std::to_string(id++) + ".log";
+   const char* msg = "value 123456 of bench at 61728.000000";
+   {
+      evo::Writer writer(file);
+      evo::RecordStore store;
+      for(std::uint64_t done = 0; done < calls; done += batch)
+      {
+         for(unsigned int i = 0; i < batch; i++)
+         {
+            store.append(evo::Clock::raw(), evo::Log::INFO, msg, std::strlen(msg));
+         }
+         measure(s, 1, 1, [&](std::uint64_t) { writer.write(store); });
+         s.back() /= batch;
+      }
+      writer.flush();
+   }
+   std::remove(file.c_str());
+   std::remove((file + ".idx").c_str());
+}
+
+/**
+ * Benchmark case
+ */
+struct Case
+{
+   const char* name; ///< name in results
+   void (*run)(Samples&, const std::uint64_t, const unsigned int); ///< runs calls
+   unsigned int batch;  ///< calls per latency sample
+   std::uint64_t calls; ///< fixed calls per thread, 0 for --calls
+};
+
+const Case CASES[] = {
+    {"log_info_cstr", infoCstr, 16, 0},
+    {"log_info_printf", infoPrintf, 16, 0},
+    {"log_stream_info", infoStream, 16, 0},
+    {"log_info_fields", infoFields, 16, 0},
+    {"log_debug_disabled", debugDisabled, 256, 0},
+    {"time_now", timeNow, 256, 0},
+    {"time_to_string", timeToString, 16, 0},
+    {"timer_auto_us", timerAutoUs, 16, 0},
+    {"profile_scope", profileScope, 256, 0},
+    {"format_int", formatInt, 16, 0},
+    {"format_int_snprintf", formatIntSnprintf, 16, 0},
+    {"format_float", formatFloat, 16, 0},
+    {"format_float_snprintf", formatFloatSnprintf, 16, 0},
+    {"format_string", formatString, 16, 0},
+    {"format_string_snprintf", formatStringSnprintf, 16, 0},
+    {"encode_fields_4", encodeFields4, 16, 0},
+    {"encode_printf_4", encodePrintf4, 16, 0},
+    {"writer_write_1e6", writerWrite, 1000, 1000000},
+};
+
+double percentile(const Samples& sorted, const double p)
+{
+   const std::size_t idx = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+   return sorted[idx];
+}
+
+/**
+ * Runs case with given number of threads, all threads start together
+ */
+Result run(const Case& c, const unsigned int threads, const Options& opt)
+{
+   const std::uint64_t calls = c.calls ? c.calls : opt.calls;
+   std::vector<Samples> samples(threads);
+   std::atomic<unsigned int> ready(0);
+   std::atomic<bool> go(false);
+   std::vector<std::thread> pool;
+   for(unsigned int t = 0; t < threads; t++)
+   {
+      pool.emplace_back([&, t]() {
+         ready++;
+         while(!go.load(std::memory_order_acquire))
+         {
+            std::this_thread::yield();
+         }
+         c.run(samples[t], calls, c.batch);
+      });
+   }
+   while(ready.load() < threads)
+   {
+      std::this_thread::yield();
+   }
+   const auto start = std::chrono::steady_clock::now();
+   go.store(true, std::memory_order_release);
+   for(std::thread& thread : pool)
+   {
+      thread.join();
+   }
+   const std::chrono::duration<double> wall =
+       std::chrono::steady_clock::now() - start;
+
+   Samples all;
+   for(const Samples& s : samples)
+   {
+      all.insert(all.end(), s.begin(), s.end());
+   }
+   std::sort(all.begin(), all.end());
+   double sum = 0.0;
+   for(const double v : all)
+   {
+      sum += v;
+   }
+
+   Result r;
+   r.name    = c.name;
+   r.threads = threads;
+   r.calls   = calls * threads;
+   r.batch   = c.batch;
+   r.min     = all.front();
+   r.mean    = sum / static_cast<double>(all.size());
+   r.p50     = percentile(all, 0.5);
+   r.p90     = percentile(all, 0.9);
+   r.p99     = percentile(all, 0.99);
+   r.p999    = percentile(all, 0.999);
+   r.max     = all.back();
+   r.ops     = static_cast<double>(r.calls) / wall.count();
+   return r;
+}
+
+const char* buildType()
+{
+#if defined(__OPTIMIZE__) && defined(NDEBUG)
+   return "release";
+#elif defined(__OPTIMIZE__)
+   return "optimized";
+#else
+   return "debug";
+#endif
+}
+
+void writeCsv(std::ostream& out, const std::vector<Result>& results)
+{
+   out << "name,threads,calls,batch,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,"
+          "max_ns,ops_per_sec,build\n";
+   char line[512];
+   for(const Result& r : results)
+   {
+      std::snprintf(line, sizeof(line),
+                    "%s,%u,%llu,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f,%.0f,%s\n",
+                    r.name.c_str(), r.threads,
+                    static_cast<unsigned long long>(r.calls), r.batch, r.min, r.mean,
+                    r.p50, r.p90, r.p99, r.p999, r.max, r.ops, buildType());
+      out << line;
+   }
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results,
+               const Options& opt)
+{
+   out << "{\"build\":\"" << buildType() << "\",\"async\":"
+       << (opt.async ? "true" : "false")
+       << ",\"stats\":" << (opt.stats ? "true" : "false")
+       << ",\"hardware_threads\":" << std::thread::hardware_concurrency()
+       << ",\"results\":[";
+   char line[512];
+   for(std::size_t i = 0; i < results.size(); i++)
+   {
+      const Result& r = results[i];
+      std::snprintf(line, sizeof(line),
+                    "%s\n{\"name\":\"%s\",\"threads\":%u,\"calls\":%llu,"
+                    "\"batch\":%u,\"min_ns\":%.1f,\"mean_ns\":%.1f,\"p50_ns\":%.1f,"
+                    "\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"p999_ns\":%.1f,"
+                    "\"max_ns\":%.1f,\"ops_per_sec\":%.0f}",
+                    i ? "," : "", r.name.c_str(), r.threads,
+                    static_cast<unsigned long long>(r.calls), r.batch, r.min, r.mean,
+                    r.p50, r.p90, r.p99, r.p999, r.max, r.ops);
+      out << line;
+   }
+   out << "\n]}\n";
+}
+
+/**
+ * Compares p50 latency and throughput with a CSV result of writeCsv()
+ *
+ * @return number of regressions, -1 if file could not be read
+ */
+int compare(const std::string& file, const std::vector<Result>& results,
+            const double tolerance)
+{
+   std::ifstream in(file);
+   if(!in)
+   {
+      return -1;
+   }
+   std::map<std::string, std::pair<double, double>> base; // p50, ops
+   std::string line;
+   std::getline(in, line); // header
+   while(std::getline(in, line))
+   {
+      std::vector<std::string> cols;
+      std::stringstream ss(line);
+      for(std::string col; std::getline(ss, col, ',');)
+      {
+         cols.push_back(col);
+      }
+      if(cols.size() >= 12)
+      {
+         base[cols[0] + "/" + cols[1]] = {std::atof(cols[6].c_str()),
+                                          std::atof(cols[11].c_str())};
+      }
+   }
+
+   int regressions = 0;
+   const double f  = 1.0 + tolerance / 100.0;
+   for(const Result& r : results)
+   {
+      const auto it = base.find(r.name + "/" + std::to_string(r.threads));
+      if(it == base.end())
+      {
+         continue;
+      }
+      const bool slower = r.p50 > it->second.first * f;
+      const bool less   = r.ops * f < it->second.second;
+      if(slower || less)
+      {
+         std::fprintf(stderr,
+                      "regression %s threads %u: p50 %.1f ns (was %.1f), %.0f ops/s "
+                      "(was %.0f)\n",
+                      r.name.c_str(), r.threads, r.p50, it->second.first, r.ops,
+                      it->second.second);
+         regressions++;
+      }
+   }
+   return regressions;
+}
+
+bool parseArgs(int argc, char** argv, Options& opt)
+{
+   for(int i = 1; i < argc; i++)
+   {
+      const std::string arg = argv[i];
+      if(i + 1 >= argc && arg != "--async" && arg != "--stats")
+      {
+         return false;
+      }
+      if(arg == "--threads")
+      {
+         opt.threads =
+             static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+      }
+      else if(arg == "--calls")
+      {
+         opt.calls = std::strtoull(argv[++i], nullptr, 10);
+      }
+      else if(arg == "--filter")
+      {
+         opt.filter = argv[++i];
+      }
+      else if(arg == "--format")
+      {
+         const std::string format = argv[++i];
+         if(format != "csv" && format != "json")
+         {
+            return false;
+         }
+         opt.json = format == "json";
+      }
+      else if(arg == "--output")
+      {
+         opt.output = argv[++i];
+      }
+      else if(arg == "--async")
+      {
+         opt.async = true;
+      }
+      else if(arg == "--stats")
+      {
+         opt.stats = true;
+      }
+      else if(arg == "--compare")
+      {
+         opt.compare = argv[++i];
+      }
+      else if(arg == "--tolerance")
+      {
+         opt.tolerance = std::atof(argv[++i]);
+      }
+      else
+      {
+         return false;
+      }
+   }
+   return opt.threads > 0 && opt.calls >= 256;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+   Options opt;
+   if(!parseArgs(argc, argv, opt))
+   {
+      std::cerr << "usage: " << argv[0]
+                << " [--threads N] [--calls N (>= 256)] [--filter NAME]"
+                   " [--format csv|json] [--output FILE] [--async] [--stats]"
+                   " [--compare FILE] [--tolerance PERCENT]"
+                << std::endl;
+      return 1;
+   }
+
+   evo::log::init("evo_log_bench");
+   evo::Logger& logger = evo::log::get();
+   logger.setLogLevel(0); // no terminal output
+   logger.setFileLogLevel(evo::Log::INFO | evo::Log::WARN | evo::Log::ERROR);
+   evo::RotationPolicy policy;
+   policy.max_bytes = 64 << 20;
+   policy.max_files = 2;
+   policy.compress  = false; // no background load
+   logger.setRotationPolicy(policy);
+   if(opt.async)
+   {
+      logger.enableAsync();
+   }
+   if(opt.stats)
+   {
+      logger.enableStats();
+   }
+
+   std::vector<Result> results;
+   for(const Case& c : CASES)
+   {
+      if(!opt.filter.empty() && std::strstr(c.name, opt.filter.c_str()) == nullptr)
+      {
+         continue;
+      }
+      for(unsigned int threads = 1;; threads *= 2)
+      {
+         threads = std::min(threads, opt.threads);
+         results.push_back(run(c, threads, opt));
+         const Result& r = results.back();
+         std::fprintf(stderr,
+                      "%-22s %2u threads  p50 %9.1f ns  p99 %9.1f ns  %12.0f/s\n",
+                      r.name.c_str(), r.threads, r.p50, r.p99, r.ops);
+         if(threads == opt.threads)
+         {
+            break;
+         }
+      }
+   }
+
+   std::ofstream file;
+   if(!opt.output.empty())
+   {
+      file.open(opt.output, std::ios::out | std::ios::trunc);
+      if(!file)
+      {
+         std::cerr << "could not open " << opt.output << std::endl;
+         return 1;
+      }
+   }
+   std::ostream& out = opt.output.empty() ? std::cout : file;
+   if(opt.json)
+   {
+      writeJson(out, results, opt);
+   }
+   else
+   {
+      writeCsv(out, results);
+   }
+   out.flush();
+   if(opt.stats)
+   {
+      std::cerr << logger.getStats().toString() << std::endl;
+   }
+
+   if(!opt.compare.empty())
+   {
+      const int regressions = compare(opt.compare, results, opt.tolerance);
+      if(regressions < 0)
+      {
+         std::cerr << "could not read " << opt.compare << std::endl;
+         return 1;
+      }
+      if(regressions > 0)
+      {
+         return 2;
+      }
+   }
+   return 0;
+}
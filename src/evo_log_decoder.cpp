@@ -0,0 +1,50 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * Converts binary log files (.blog, see evo::BinaryLog) to the text format of the
+ * .log files.
+ *
+ * usage: evo_log_decoder <file.blog> [output.log]
+ */
+
+#include <fstream>
+#include <iostream>
+
+#include "evo_logger/log/BinaryLog.h"
+#include "evo_logger/log/LogType.h"
+
+int main(int argc, char** argv)
+{
+   if(argc < 2 || argc > 3)
+   {
+      std::cerr << "usage: " << argv[0] << " <file.blog> [output.log]" << std::endl;
+      return 1;
+   }
+
+   std::ofstream file;
+   if(argc == 3)
+   {
+      file.open(argv[2], std::ios::out | std::ios::trunc);
+      if(!file)
+      {
+         std::cerr << "could not open " << argv[2] << std::endl;
+         return 1;
+      }
+   }
+   std::ostream& out = (argc == 3) ? file : std::cout;
+
+   const bool ok = evo::BinaryReader::read(
+       argv[1], [&out](const evo::LogObj& obj) { out << evo::LogObj::parse(obj) << '\n'; });
+   out.flush();
+
+   if(!ok)
+   {
+      std::cerr << "could not decode " << argv[1] << " (missing or corrupted)"
+                << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,134 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * Prints the logs of a .log file in a time range and with given levels, uses the
+ * index "<file.log>.idx" if it exists (see evo::LogReader). Times are given in the
+ * format of the log file ("20190304_12-00-00[.123]", local time) or "-" for no
+ * limit, levels as comma separated list (default all). Statistics are printed to
+ * stderr.
+ *
+ * usage: evo_log_query [--index | --scan] <file.log> [from] [to] [levels]
+ *   --index  (re)build index of file before the query
+ *   --scan   ignore index, parse whole file
+ *
+ * example: evo_log_query run.log 20190304_12-00-00 20190304_12-05-00 WARN,ERROR
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "evo_logger/log/LogReader.h"
+#include "evo_logger/time/TimeFormatter.h"
+
+namespace {
+
+bool parseTime(const std::string& arg, std::int64_t& ns, const std::int64_t open)
+{
+   if(arg == "-")
+   {
+      ns = open;
+      return true;
+   }
+   return evo::TimeFormatter::parse(arg.data(), arg.size(), ns) == arg.size();
+}
+
+bool parseLevels(const std::string& arg, evo::LogType& levels)
+{
+   levels            = 0;
+   std::size_t start = 0;
+   while(start <= arg.size())
+   {
+      std::size_t end  = arg.find(',', start);
+      end              = end == std::string::npos ? arg.size() : end;
+      std::string name = arg.substr(start, end - start);
+      if(name.size() > 5)
+      {
+         return false;
+      }
+      name.resize(5, ' '); // "WARN" -> "WARN "
+      evo::Log::Log level;
+      if(!evo::LogReader::parseLevel(name.data(), level))
+      {
+         return false;
+      }
+      levels |= static_cast<evo::LogType>(level);
+      start = end + 1;
+   }
+   return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+   int arg    = 1;
+   bool build = false;
+   bool scan  = false;
+   for(; arg < argc && argv[arg][0] == '-' && argv[arg][1] == '-'; arg++)
+   {
+      build |= std::strcmp(argv[arg], "--index") == 0;
+      scan |= std::strcmp(argv[arg], "--scan") == 0;
+   }
+   const int count = argc - arg;
+   if(count < 1 || count > 4 || (build && scan))
+   {
+      std::cerr << "usage: " << argv[0]
+                << " [--index | --scan] <file.log> [from] [to] [levels]"
+                << std::endl;
+      return 1;
+   }
+
+   std::int64_t from   = std::numeric_limits<std::int64_t>::min();
+   std::int64_t to     = std::numeric_limits<std::int64_t>::max();
+   evo::LogType levels = evo::Log::ALL;
+   if((count >= 2 && !parseTime(argv[arg + 1], from, from)) ||
+      (count >= 3 && !parseTime(argv[arg + 2], to, to)))
+   {
+      std::cerr << "invalid time, expected YYYYmmdd_HH-MM-SS[.frac] or -"
+                << std::endl;
+      return 1;
+   }
+   if(count == 4 && !parseLevels(argv[arg + 3], levels))
+   {
+      std::cerr << "invalid levels " << argv[arg + 3] << ", expected e.g. WARN,ERROR"
+                << std::endl;
+      return 1;
+   }
+
+   evo::LogReader reader(argv[arg]);
+   if(!reader.isOpen())
+   {
+      std::cerr << reader.lastError() << std::endl;
+      return 1;
+   }
+   if(build && !reader.buildIndex())
+   {
+      std::cerr << reader.lastError() << std::endl;
+      return 1;
+   }
+   reader.setUseIndex(!scan);
+
+   const auto start = std::chrono::steady_clock::now();
+   const std::size_t matches =
+       reader.query(from, to, levels, [](const evo::LogReader::Line& line) {
+          std::cout.write(line.data, static_cast<std::streamsize>(line.size));
+          std::cout << '\n';
+       });
+   std::cout.flush();
+   const auto took = std::chrono::steady_clock::now() - start;
+
+   std::cerr << matches << " logs, parsed " << reader.scanned() << " of "
+             << reader.size() << " bytes"
+             << (reader.hasIndex() && !scan ? " with index" : " without index")
+             << " in "
+             << std::chrono::duration_cast<std::chrono::microseconds>(took).count()
+             << " us" << std::endl;
+   return 0;
+}
@@ -0,0 +1,65 @@
+//###############################################################
+//# Copyright (C) 2019, Evocortex GmbH, All rights reserved.    #
+//# Further regulations can be found in LICENSE file.           #
+//###############################################################
+
+/**
+ * Extracts the latest logs from a ring file left by a crashed process (.ring, see
+ * evo::FlightRecorder) in the text format of the .log files.
+ *
+ * usage: evo_log_recover <file.ring> [count] [output.log]
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "evo_logger/log/FlightRecorder.h"
+#include "evo_logger/log/LogType.h"
+
+int main(int argc, char** argv)
+{
+   if(argc < 2 || argc > 4)
+   {
+      std::cerr << "usage: " << argv[0] << " <file.ring> [count] [output.log]"
+                << std::endl;
+      return 1;
+   }
+
+   std::size_t count = 0;
+   if(argc >= 3)
+   {
+      char* end = nullptr;
+      count     = std::strtoul(argv[2], &end, 10);
+      if(*end != '\0')
+      {
+         std::cerr << "invalid count " << argv[2] << std::endl;
+         return 1;
+      }
+   }
+
+   std::ofstream file;
+   if(argc == 4)
+   {
+      file.open(argv[3], std::ios::out | std::ios::trunc);
+      if(!file)
+      {
+         std::cerr << "could not open " << argv[3] << std::endl;
+         return 1;
+      }
+   }
+   std::ostream& out = (argc == 4) ? file : std::cout;
+
+   const bool ok = evo::FlightReader::read(
+       argv[1], count,
+       [&out](const evo::LogObj& obj) { out << evo::LogObj::parse(obj) << '\n'; });
+   out.flush();
+
+   if(!ok)
+   {
+      std::cerr << "could not read " << argv[1] << " (missing or no ring file)"
+                << std::endl;
+      return 1;
+   }
+   return 0;
+}
@@ -7,6 +7,7 @@
 #include "evo_logger/log/LogType.h"
 #include "evo_logger/log/OstreamColor.h"
 #include "evo_logger/log/Writer.h"
+#include "evo_logger/time/Profiler.h"
 #include "evo_logger/time/Time.h"
 #include "evo_logger/time/Timer.h"
 #include "evo_logger/base/System.h"